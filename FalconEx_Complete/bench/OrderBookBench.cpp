@@ -0,0 +1,626 @@
+// OrderBook microbenchmarks: add-passive, add-aggressive (sweeping 1/5/50 levels),
+// cancel, modify, top-of-book query and a mixed random flow against pre-populated books
+// of several sizes in dense and sparse price layouts. Prints a table and writes JSON.
+// With --latency it also records the per-order latency distribution of several client
+// threads sharing one book, for each lock wait mode and for heap vs huge-page memory.
+//
+//   falconex_bench [--sizes 1000,100000,10000000] [--layouts dense,sparse]
+//                  [--min-time-ms 200] [--huge-pages] [--out bench.json]
+//                  [--latency] [--wait-modes block,spin,busy] [--latency-threads 2]
+//                  [--latency-ops 100000] [--cpus 0,1]
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Clock.h"
+#include "HugePages.h"
+#include "OrderBook.h"
+#include "Threading.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Makes the compiler treat `value` as read, so a timed call whose result is otherwise
+// unused (a top-of-book query, a cancel or modify status) is neither dropped nor
+// hoisted out of its loop.
+template <typename T>
+static inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+// Cycle, cache-miss and branch-miss counters for this thread via perf_event_open. Any
+// counter can be missing (containers, VMs, perf_event_paranoid); its result is then null.
+class PerfCounters {
+private:
+    int cyclesFd = -1;
+    int missesFd = -1;
+    int branchMissesFd = -1;
+
+#ifdef __linux__
+    static int openCounter(uint64_t config) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    static long long readCounter(int fd) {
+        long long value = 0;
+        if (fd < 0 || read(fd, &value, sizeof(value)) != sizeof(value)) return 0;
+        return value;
+    }
+#endif
+
+public:
+    PerfCounters() {
+#ifdef __linux__
+        cyclesFd = openCounter(PERF_COUNT_HW_CPU_CYCLES);
+        missesFd = openCounter(PERF_COUNT_HW_CACHE_MISSES);
+        branchMissesFd = openCounter(PERF_COUNT_HW_BRANCH_MISSES);
+#endif
+    }
+
+    ~PerfCounters() {
+#ifdef __linux__
+        if (cyclesFd >= 0) close(cyclesFd);
+        if (missesFd >= 0) close(missesFd);
+        if (branchMissesFd >= 0) close(branchMissesFd);
+#endif
+    }
+
+    bool hasCycles() const { return cyclesFd >= 0; }
+    bool hasMisses() const { return missesFd >= 0; }
+    bool hasBranchMisses() const { return branchMissesFd >= 0; }
+
+    long long cycles() const {
+#ifdef __linux__
+        return readCounter(cyclesFd);
+#else
+        return 0;
+#endif
+    }
+
+    long long misses() const {
+#ifdef __linux__
+        return readCounter(missesFd);
+#else
+        return 0;
+#endif
+    }
+
+    long long branchMisses() const {
+#ifdef __linux__
+        return readCounter(branchMissesFd);
+#else
+        return 0;
+#endif
+    }
+};
+
+struct Result {
+    string op;
+    string layout;
+    long bookOrders;
+    long iterations;
+    double nsPerOp;
+    double cyclesPerOp;  // NaN when the counter is unavailable
+    double missesPerOp;
+    double branchMissesPerOp;
+};
+
+// Accumulates time and counter deltas over the timed sections of one benchmark.
+class Measurement {
+private:
+    const PerfCounters& perf;
+    long long ns = 0;
+    long long cycles = 0;
+    long long misses = 0;
+    long long branchMisses = 0;
+    long ops = 0;
+    uint64_t t0 = 0;
+    long long c0 = 0;
+    long long m0 = 0;
+    long long b0 = 0;
+
+public:
+    explicit Measurement(const PerfCounters& counters) : perf(counters) {}
+
+    void start() {
+        c0 = perf.cycles();
+        m0 = perf.misses();
+        b0 = perf.branchMisses();
+        t0 = TscClock::ticks();
+    }
+
+    void stop(long batchOps) {
+        uint64_t t1 = TscClock::ticks();
+        ns += TscClock::elapsedNs(t0, t1);
+        cycles += perf.cycles() - c0;
+        misses += perf.misses() - m0;
+        branchMisses += perf.branchMisses() - b0;
+        ops += batchOps;
+    }
+
+    long long elapsedNs() const { return ns; }
+    long iterations() const { return ops; }
+
+    // Every per-op figure is NaN (null in the JSON) when nothing was timed.
+    Result result(const string& op, const string& layout, long bookOrders) const {
+        double n = static_cast<double>(ops);
+        if (ops == 0) return {op, layout, bookOrders, 0, NAN, NAN, NAN, NAN};
+        return {op, layout, bookOrders, ops, ns / n,
+                perf.hasCycles() ? cycles / n : NAN,
+                perf.hasMisses() ? misses / n : NAN,
+                perf.hasBranchMisses() ? branchMisses / n : NAN};
+    }
+};
+
+// A book filled with `size` resting orders, half per side, priced in integer ticks
+// around a fixed mid. Dense books pack ~10 orders onto every tick next to the
+// spread; sparse books spread orders over ten times as many ticks as orders, so most
+// populated levels hold one order and are separated by empty ticks.
+class BookFixture {
+private:
+    static constexpr long kMid = 100000000;  // ticks
+    static constexpr double kTick = 0.01;
+
+    long ticksPerSide;
+    mt19937_64 rng{12345};
+    int nextId = 1;
+
+public:
+    struct Live {
+        int id;
+        Side side;
+    };
+
+    OrderBook<> book;
+    vector<Live> live;
+
+    BookFixture(long size, bool dense, std::pmr::memory_resource* memory)
+        : ticksPerSide(max(1L, dense ? size / 2 / 10 : size / 2 * 10)), book(memory) {
+        book.setTradeEcho(false);
+        live.reserve(size);
+        for (long i = 0; i < size; ++i) live.push_back(add(i % 2 == 0 ? Side::BUY : Side::SELL));
+    }
+
+    static double price(long ticks) { return ticks * kTick; }
+
+    // A random non-crossing price on the given side.
+    double passivePrice(Side side) {
+        long offset = 1 + static_cast<long>(rng() % static_cast<uint64_t>(ticksPerSide));
+        return price(side == Side::BUY ? kMid - offset : kMid + offset);
+    }
+
+    Order make(Side side, double px, int qty) {
+        return Order{
+            .id = nextId++,
+            .symbol = "AAPL",
+            .side = side,
+            .type = OrderType::LIMIT,
+            .quantity = qty,
+            .price = px
+        };
+    }
+
+    Live add(Side side) {
+        Order o = make(side, passivePrice(side), 1 + static_cast<int>(rng() % 100));
+        book.addOrder(o);
+        return {o.id, side};
+    }
+
+    size_t randomLiveIndex() { return rng() % live.size(); }
+
+    // Adds resting orders on `side` until it has at least `levels` price levels, since
+    // earlier benchmarks (mixed_flow) trade some away. False when the layout has fewer
+    // ticks than that.
+    bool ensureLevels(Side side, int levels) {
+        if (levels > ticksPerSide) return false;
+        for (long tries = 0; static_cast<int>(book.depth(side, levels).size()) < levels; ++tries) {
+            if (tries > ticksPerSide * 50) return false;
+            live.push_back(add(side));
+        }
+        return true;
+    }
+};
+
+static void benchTopOfBook(BookFixture& f, Measurement& m, long long budgetNs) {
+    const long batch = 10000;
+    while (m.elapsedNs() < budgetNs) {
+        m.start();
+        for (long i = 0; i < batch; ++i) {
+            TopOfBook top = f.book.topOfBook();
+            doNotOptimize(top);
+        }
+        m.stop(batch);
+    }
+}
+
+static void benchAddPassive(BookFixture& f, Measurement& m, long long budgetNs, long batch) {
+    vector<Order> pending;
+    pending.reserve(batch);
+    while (m.elapsedNs() < budgetNs) {
+        pending.clear();
+        for (long i = 0; i < batch; ++i) {
+            Side side = i % 2 == 0 ? Side::BUY : Side::SELL;
+            pending.push_back(f.make(side, f.passivePrice(side), 10));
+        }
+        m.start();
+        for (const auto& o : pending) {
+            f.book.addOrder(o);
+            f.book.matchOrders();
+        }
+        m.stop(batch);
+        for (const auto& o : pending) f.book.cancelOrder(o.id);
+    }
+}
+
+static void benchCancel(BookFixture& f, Measurement& m, long long budgetNs, long batch) {
+    if (static_cast<long>(f.live.size()) < batch) return;
+    vector<int> victims;
+    victims.reserve(batch);
+    while (m.elapsedNs() < budgetNs) {
+        victims.clear();
+        for (long i = 0; i < batch; ++i) {
+            size_t idx = f.randomLiveIndex();
+            victims.push_back(f.live[idx].id);
+            f.live[idx] = f.live.back();
+            f.live.pop_back();
+        }
+        m.start();
+        for (int id : victims) {
+            bool cancelled = f.book.cancelOrder(id);
+            doNotOptimize(cancelled);
+        }
+        m.stop(batch);
+        for (long i = 0; i < batch; ++i) f.live.push_back(f.add(i % 2 == 0 ? Side::BUY : Side::SELL));
+    }
+}
+
+// Price changes within the same side: the cancel/replace path, which loses priority.
+static void benchModify(BookFixture& f, Measurement& m, long long budgetNs, long batch) {
+    struct Change { int id; double price; int qty; };
+    vector<Change> changes;
+    changes.reserve(batch);
+    if (f.live.empty()) return;
+    while (m.elapsedNs() < budgetNs) {
+        changes.clear();
+        for (long i = 0; i < batch; ++i) {
+            const auto& target = f.live[f.randomLiveIndex()];
+            changes.push_back({target.id, f.passivePrice(target.side), 1 + static_cast<int>(i % 100)});
+        }
+        m.start();
+        for (const auto& c : changes) {
+            bool modified = f.book.modifyOrder(c.id, c.price, c.qty);
+            doNotOptimize(modified);
+        }
+        m.stop(batch);
+    }
+}
+
+// One aggressive buy takes out the best `levels` ask levels; the swept levels are then
+// rebuilt (same price, order count and total quantity) outside the timed section.
+static void benchAddAggressive(BookFixture& f, Measurement& m, long long budgetNs, int levels) {
+    while (m.elapsedNs() < budgetNs) {
+        if (!f.ensureLevels(Side::SELL, levels)) return;
+        vector<LevelInfo> asks = f.book.depth(Side::SELL, levels);
+        long qty = 0;
+        for (const auto& level : asks) qty += level.quantity;
+        Order sweep = f.make(Side::BUY, asks.back().price, static_cast<int>(qty));
+
+        m.start();
+        f.book.addOrder(sweep);
+        f.book.matchOrders();
+        m.stop(1);
+
+        for (const auto& level : asks) {
+            long each = level.quantity / level.orders;
+            long first = level.quantity - each * (level.orders - 1);
+            for (int k = 0; k < level.orders; ++k) {
+                f.book.addOrder(f.make(Side::SELL, level.price, static_cast<int>(k == 0 ? first : each)));
+            }
+        }
+        f.book.clearTradeLog();
+    }
+}
+
+// Unpredictable flow: every op is a random side and a random mix of passive limits,
+// marketable limits one tick through the touch and small market orders, so the side
+// and order-type branches on the add/match path cannot be learned.
+static void benchMixedFlow(BookFixture& f, Measurement& m, long long budgetNs, long batch) {
+    mt19937 rng(99);
+    vector<Order> pending;
+    pending.reserve(batch);
+    while (m.elapsedNs() < budgetNs) {
+        pending.clear();
+        if (!f.ensureLevels(Side::BUY, 1) || !f.ensureLevels(Side::SELL, 1)) return;
+        TopOfBook top = f.book.topOfBook();
+        for (long i = 0; i < batch; ++i) {
+            Side side = rng() % 2 == 0 ? Side::BUY : Side::SELL;
+            unsigned kind = rng() % 10;
+            if (kind < 6) {
+                pending.push_back(f.make(side, f.passivePrice(side), 10));
+            } else if (kind < 9) {
+                double through = side == Side::BUY ? top.askPrice + 0.01 : top.bidPrice - 0.01;
+                pending.push_back(f.make(side, through, 5));
+            } else {
+                Order o = f.make(side, 0.0, 5);
+                o.type = OrderType::MARKET;
+                pending.push_back(o);
+            }
+        }
+        m.start();
+        for (const auto& o : pending) {
+            f.book.addOrder(o);
+            f.book.matchOrders();
+        }
+        m.stop(batch);
+        for (const auto& o : pending) f.book.cancelOrder(o.id);
+        f.book.clearTradeLog();
+    }
+}
+
+struct LatencyResult {
+    string waitMode;
+    string memory;
+    int threads;
+    long samples;
+    double p50;
+    double p90;
+    double p99;
+    double p999;
+    double max;
+};
+
+// `threads` clients share one book pre-filled with 10k orders, each timing its own
+// addOrder + matchOrders (lock wait included) with random passive and crossing limits
+// around a fixed mid. Every other op also cancels one of the client's older orders, so
+// the book stays near its starting size.
+static LatencyResult benchLatency(WaitMode mode, bool hugePages, int threads, long opsPerThread,
+                                  const vector<int>& cpus) {
+    HugePageResource hugeMemory;
+    OrderBook<> book(hugePages ? static_cast<std::pmr::memory_resource*>(&hugeMemory)
+                               : std::pmr::get_default_resource());
+    book.setTradeEcho(false);
+    book.setWaitMode(mode);
+
+    const long mid = 10000;  // ticks
+    auto order = [](int id, Side side, long ticks, int qty) {
+        return Order{.id = id, .symbol = "AAPL", .side = side, .type = OrderType::LIMIT, .quantity = qty,
+                     .price = ticks * 0.01};
+    };
+    mt19937 fill(7);
+    for (int id = 1; id <= 10000; ++id) {
+        Side side = id % 2 == 0 ? Side::BUY : Side::SELL;
+        long offset = 1 + static_cast<long>(fill() % 200);
+        book.addOrder(order(id, side, side == Side::BUY ? mid - offset : mid + offset, 1 + static_cast<int>(fill() % 50)));
+    }
+
+    vector<vector<uint32_t>> samples(threads);
+    atomic<int> ready{0};
+    atomic<bool> go{false};
+    vector<thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            int cpu = cpuFor(cpus, t);
+            if (cpu >= 0 && !pinThisThread(cpu)) cerr << "cannot pin latency thread to CPU " << cpu << "\n";
+            mt19937 rng(100 + t);
+            vector<uint32_t>& out = samples[t];
+            out.reserve(opsPerThread);
+            vector<int> mine;
+            int nextId = (t + 1) * 100000000;
+            ready.fetch_add(1);
+            while (!go.load(memory_order_acquire)) cpuRelax();
+
+            for (long i = 0; i < opsPerThread; ++i) {
+                Side side = rng() % 2 == 0 ? Side::BUY : Side::SELL;
+                long offset = static_cast<long>(rng() % 60) - 10;  // a sixth cross the touch
+                long ticks = side == Side::BUY ? mid - offset : mid + offset;
+                Order o = order(nextId++, side, ticks, 1 + static_cast<int>(rng() % 20));
+                uint64_t t0 = TscClock::ticks();
+                book.addOrder(o);
+                book.matchOrders();
+                uint64_t t1 = TscClock::ticks();
+                out.push_back(static_cast<uint32_t>(min<long>(TscClock::elapsedNs(t0, t1), UINT32_MAX)));
+                mine.push_back(o.id);
+                if (i % 2 == 1) {
+                    size_t k = rng() % mine.size();
+                    book.cancelOrder(mine[k]);
+                    mine[k] = mine.back();
+                    mine.pop_back();
+                }
+            }
+        });
+    }
+    while (ready.load() < threads) this_thread::yield();
+    go.store(true, memory_order_release);
+    for (auto& w : workers) w.join();
+
+    vector<uint32_t> all;
+    for (const auto& s : samples) all.insert(all.end(), s.begin(), s.end());
+    sort(all.begin(), all.end());
+    auto pct = [&](double q) {
+        return all.empty() ? NAN : static_cast<double>(all[min(all.size() - 1, static_cast<size_t>(q * all.size()))]);
+    };
+    return {waitModeName(mode), hugePages ? pageBackingName(hugeMemory.reserve()) : "heap", threads,
+            static_cast<long>(all.size()), pct(0.50), pct(0.90), pct(0.99), pct(0.999),
+            all.empty() ? NAN : static_cast<double>(all.back())};
+}
+
+static vector<long> parseSizes(const string& csv) {
+    vector<long> out;
+    stringstream ss(csv);
+    string item;
+    while (getline(ss, item, ',')) if (!item.empty()) out.push_back(stol(item));
+    return out;
+}
+
+static vector<string> parseList(const string& csv) {
+    vector<string> out;
+    stringstream ss(csv);
+    string item;
+    while (getline(ss, item, ',')) if (!item.empty()) out.push_back(item);
+    return out;
+}
+
+static string jsonNumber(double v) {
+    if (std::isnan(v)) return "null";
+    stringstream ss;
+    ss << fixed << setprecision(2) << v;
+    return ss.str();
+}
+
+static void writeJson(const string& path, const vector<Result>& results, const vector<LatencyResult>& latencies,
+                      const PerfCounters& perf, const string& memory) {
+    ofstream out(path);
+    out << "{\n  \"benchmark\": \"orderbook\",\n";
+    out << "  \"memory\": \"" << memory << "\",\n";
+    out << "  \"perf_counters\": {\"cycles\": " << (perf.hasCycles() ? "true" : "false")
+        << ", \"cache_misses\": " << (perf.hasMisses() ? "true" : "false")
+        << ", \"branch_misses\": " << (perf.hasBranchMisses() ? "true" : "false") << "},\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << "    {\"op\": \"" << r.op << "\", \"layout\": \"" << r.layout << "\", \"book_orders\": " << r.bookOrders
+            << ", \"iterations\": " << r.iterations << ", \"ns_per_op\": " << jsonNumber(r.nsPerOp)
+            << ", \"cycles_per_op\": " << jsonNumber(r.cyclesPerOp)
+            << ", \"cache_misses_per_op\": " << jsonNumber(r.missesPerOp)
+            << ", \"branch_misses_per_op\": " << jsonNumber(r.branchMissesPerOp) << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ],\n  \"latency\": [\n";
+    for (size_t i = 0; i < latencies.size(); ++i) {
+        const LatencyResult& r = latencies[i];
+        out << "    {\"wait_mode\": \"" << r.waitMode << "\", \"memory\": \"" << r.memory << "\", \"threads\": "
+            << r.threads << ", \"samples\": " << r.samples << ", \"p50_ns\": " << jsonNumber(r.p50)
+            << ", \"p90_ns\": " << jsonNumber(r.p90) << ", \"p99_ns\": " << jsonNumber(r.p99)
+            << ", \"p999_ns\": " << jsonNumber(r.p999) << ", \"max_ns\": " << jsonNumber(r.max) << "}"
+            << (i + 1 < latencies.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+int main(int argc, char** argv) {
+    vector<long> sizes = {1000, 100000, 10000000};
+    vector<string> layouts = {"dense", "sparse"};
+    long long budgetNs = 200LL * 1000000;
+    string outPath = "bench.json";
+    bool hugePages = false;
+    bool latency = false;
+    vector<string> waitModes = {"block", "spin", "busy"};
+    int latencyThreads = 2;
+    long latencyOps = 100000;
+    vector<int> cpus;
+    for (int i = 1; i < argc; i++) {
+        string a = argv[i];
+        auto get = [&](const string& k) {
+            if (i + 1 >= argc) throw runtime_error("missing " + k);
+            return string(argv[++i]);
+        };
+        if (a == "--sizes") sizes = parseSizes(get("--sizes"));
+        else if (a == "--layouts") layouts = parseList(get("--layouts"));
+        else if (a == "--min-time-ms") budgetNs = stoll(get("--min-time-ms")) * 1000000;
+        else if (a == "--out") outPath = get("--out");
+        else if (a == "--huge-pages") hugePages = true;
+        else if (a == "--latency") latency = true;
+        else if (a == "--wait-modes") waitModes = parseList(get("--wait-modes"));
+        else if (a == "--latency-threads") latencyThreads = stoi(get("--latency-threads"));
+        else if (a == "--latency-ops") latencyOps = stol(get("--latency-ops"));
+        else if (a == "--cpus") cpus = parseCpuList(get("--cpus"));
+        else cerr << "unknown arg " << a << "\n";
+    }
+
+    PerfCounters perf;
+    if (!perf.hasCycles() || !perf.hasMisses() || !perf.hasBranchMisses()) {
+        cerr << "perf_event counters unavailable; cycles/cache-misses/branch-misses reported as null\n";
+    }
+
+    HugePageResource hugeMemory;
+    std::pmr::memory_resource* memory = std::pmr::get_default_resource();
+    string memoryName = "heap";
+    if (hugePages) {
+        memoryName = pageBackingName(hugeMemory.reserve());
+        memory = &hugeMemory;
+        cerr << "book memory: " << memoryName << "\n";
+    }
+
+    vector<Result> results;
+    cout << left << setw(18) << "op" << setw(8) << "layout" << setw(10) << "orders"
+         << right << setw(12) << "iters" << setw(12) << "ns/op" << setw(12) << "cycles/op" << setw(12) << "miss/op" << setw(12) << "brmiss/op" << "\n";
+    for (long size : sizes) {
+        for (const string& layout : layouts) {
+            BookFixture fixture(size, layout == "dense", memory);
+            long batch = max(1L, min(10000L, size / 10));
+
+            auto run = [&](const string& op, auto&& body) {
+                Measurement m(perf);
+                body(m);
+                Result r = m.result(op, layout, size);
+                if (r.iterations == 0) {
+                    cout << left << setw(18) << r.op << setw(8) << r.layout << setw(10) << r.bookOrders
+                         << "skipped: the book cannot set this op up" << endl;
+                    return;
+                }
+                results.push_back(r);
+                cout << left << setw(18) << r.op << setw(8) << r.layout << setw(10) << r.bookOrders
+                     << right << setw(12) << r.iterations << setw(12) << jsonNumber(r.nsPerOp)
+                     << setw(12) << jsonNumber(r.cyclesPerOp) << setw(12) << jsonNumber(r.missesPerOp)
+                     << setw(12) << jsonNumber(r.branchMissesPerOp) << endl;
+            };
+
+            run("top_of_book", [&](Measurement& m) { benchTopOfBook(fixture, m, budgetNs); });
+            run("add_passive", [&](Measurement& m) { benchAddPassive(fixture, m, budgetNs, batch); });
+            run("cancel", [&](Measurement& m) { benchCancel(fixture, m, budgetNs, batch); });
+            run("modify", [&](Measurement& m) { benchModify(fixture, m, budgetNs, batch); });
+            run("mixed_flow", [&](Measurement& m) { benchMixedFlow(fixture, m, budgetNs, batch); });
+            for (int levels : {1, 5, 50}) {
+                run("add_aggressive_" + to_string(levels), [&](Measurement& m) { benchAddAggressive(fixture, m, budgetNs, levels); });
+            }
+        }
+    }
+
+    vector<LatencyResult> latencies;
+    if (latency) {
+        cout << "\n" << left << setw(8) << "wait" << setw(26) << "memory" << right << setw(8) << "threads"
+             << setw(10) << "samples" << setw(10) << "p50" << setw(10) << "p90" << setw(10) << "p99"
+             << setw(10) << "p99.9" << setw(14) << "max (ns)" << "\n";
+        for (const string& name : waitModes) {
+            WaitMode mode;
+            if (!parseWaitMode(name, mode)) {
+                cerr << "unknown wait mode " << name << "\n";
+                continue;
+            }
+            for (bool huge : {false, true}) {
+                LatencyResult r = benchLatency(mode, huge, latencyThreads, latencyOps, cpus);
+                latencies.push_back(r);
+                cout << left << setw(8) << r.waitMode << setw(26) << r.memory << right << setw(8) << r.threads
+                     << setw(10) << r.samples << setw(10) << jsonNumber(r.p50) << setw(10) << jsonNumber(r.p90)
+                     << setw(10) << jsonNumber(r.p99) << setw(10) << jsonNumber(r.p999) << setw(14)
+                     << jsonNumber(r.max) << endl;
+            }
+        }
+    }
+
+    writeJson(outPath, results, latencies, perf, memoryName);
+    cerr << "Wrote " << results.size() + latencies.size() << " results to " << outPath << "\n";
+    return 0;
+}
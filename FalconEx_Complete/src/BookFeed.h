@@ -0,0 +1,153 @@
+#pragma once
+// Sequenced book-event stream from the primary OrderBook to read-only replicas.
+// The book publishes while holding bookMutex, so there is exactly one producer; each
+// subscriber gets its own single-producer/single-consumer ring and drains it on its
+// own thread. A subscriber that falls a full ring behind is marked lost instead of
+// stalling the matching path, and recovers by asking the book for a snapshot.
+//
+// Events carry absolute level state (total quantity and order count after the
+// change), so applying the latest LEVEL event for a price is always enough. Every
+// locked book operation ends with BATCH_END; replicas only expose whole batches.
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Clock.h"
+
+enum class Side;
+
+enum class BookEventType : std::uint8_t {
+    CLEAR,      // start of a snapshot: drop all levels
+    LEVEL,      // a price level's new state; orders == 0 means the level is gone
+    TRADE,
+    BATCH_END   // qty holds the publish time (TscClock ns)
+};
+
+struct BookEvent {
+    std::uint64_t seq;  // snapshot events all carry the sequence they reflect
+    BookEventType type;
+    Side side;
+    int orders;
+    double price;
+    long qty;
+};
+
+class BookEventRing {
+private:
+    std::vector<BookEvent> slots;
+    std::uint64_t mask;
+    alignas(64) std::atomic<std::uint64_t> head{0};  // next slot to write
+    alignas(64) std::atomic<std::uint64_t> tail{0};  // next slot to read
+    alignas(64) std::atomic<bool> overflowed{false};
+
+public:
+    // Capacity is rounded up to a power of two.
+    explicit BookEventRing(std::size_t capacity) {
+        std::size_t n = 1;
+        while (n < capacity) n <<= 1;
+        slots.resize(n);
+        mask = n - 1;
+    }
+
+    bool push(const BookEvent& e) {
+        std::uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == slots.size()) return false;
+        slots[h & mask] = e;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(BookEvent& e) {
+        std::uint64_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        e = slots[t & mask];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Only while the producer is blocked (bookMutex held) and the consumer is waiting
+    // for its snapshot.
+    void reset() {
+        tail.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        overflowed.store(false, std::memory_order_release);
+    }
+
+    // Grows the ring to hold at least `capacity` events, dropping anything unread. Same
+    // conditions as reset().
+    void reserve(std::size_t capacity) {
+        if (capacity <= slots.size()) return;
+        std::size_t n = slots.size();
+        while (n < capacity) n <<= 1;
+        slots.assign(n, BookEvent{});
+        mask = n - 1;
+        tail.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    std::size_t capacity() const { return slots.size(); }
+
+    void markLost() { overflowed.store(true, std::memory_order_release); }
+    bool lost() const { return overflowed.load(std::memory_order_acquire); }
+
+    std::uint64_t backlog() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+};
+
+class BookFeed {
+private:
+    struct Subscriber {
+        BookEventRing ring;
+        std::atomic<std::uint64_t> lagEvents{0};
+        std::atomic<std::uint64_t> lagNs{0};
+        explicit Subscriber(std::size_t capacity) : ring(capacity) {}
+    };
+
+    std::vector<std::unique_ptr<Subscriber>> subscribers;
+    std::atomic<std::uint64_t> seq{0};
+
+public:
+    // Not synchronized with publish(): subscribe before the feed is attached to a book.
+    // The ring grows when a snapshot would not fit in it.
+    std::size_t subscribe(std::size_t capacity = 1 << 16) {
+        subscribers.push_back(std::make_unique<Subscriber>(capacity));
+        return subscribers.size() - 1;
+    }
+
+    std::size_t subscriberCount() const { return subscribers.size(); }
+    BookEventRing& ring(std::size_t sub) { return subscribers[sub]->ring; }
+
+    // Producer side, under bookMutex.
+    void publish(BookEvent e) {
+        e.seq = seq.load(std::memory_order_relaxed) + 1;
+        seq.store(e.seq, std::memory_order_release);
+        for (auto& s : subscribers) {
+            if (!s->ring.lost() && !s->ring.push(e)) s->ring.markLost();
+        }
+    }
+
+    void endBatch() {
+        publish({0, BookEventType::BATCH_END, Side{}, 0, 0.0, TscClock::nowNs()});
+    }
+
+    std::uint64_t published() const { return seq.load(std::memory_order_acquire); }
+
+    // Each replica reports its own lag; the worst one is what matters operationally.
+    void reportLag(std::size_t sub, std::uint64_t events, std::uint64_t ns) {
+        subscribers[sub]->lagEvents.store(events, std::memory_order_relaxed);
+        subscribers[sub]->lagNs.store(ns, std::memory_order_relaxed);
+    }
+
+    std::uint64_t maxLagEvents() const {
+        std::uint64_t worst = 0;
+        for (const auto& s : subscribers) worst = std::max(worst, s->lagEvents.load(std::memory_order_relaxed));
+        return worst;
+    }
+
+    std::uint64_t maxLagNs() const {
+        std::uint64_t worst = 0;
+        for (const auto& s : subscribers) worst = std::max(worst, s->lagNs.load(std::memory_order_relaxed));
+        return worst;
+    }
+};
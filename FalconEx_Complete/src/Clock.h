@@ -0,0 +1,99 @@
+#pragma once
+// Engine clock. On x86 CPUs that advertise an invariant TSC, time is read with a
+// single rdtsc and converted to nanoseconds with a rate measured once against
+// steady_clock on first use. Otherwise it falls back to steady_clock.
+//
+// TscClock::nowNs() counts from calibration (roughly process start), not the Unix
+// epoch, and never goes backwards on a given thread. Use it for order timestamps,
+// throttling and latency probes; use system_clock for anything a human reads.
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define FALCONEX_HAS_RDTSC 1
+#else
+#define FALCONEX_HAS_RDTSC 0
+#endif
+
+class TscClock {
+private:
+    struct Calibration {
+        bool tsc = false;
+        std::uint64_t tick0 = 0;
+        double nsPerTick = 1.0;
+    };
+
+    static bool invariantTsc() {
+#if FALCONEX_HAS_RDTSC
+        unsigned eax, ebx, ecx, edx;
+        if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007) return false;
+        __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+        return (edx & (1u << 8)) != 0;
+#else
+        return false;
+#endif
+    }
+
+    static std::uint64_t steadyNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static Calibration calibrate() {
+        Calibration c;
+#if FALCONEX_HAS_RDTSC
+        if (invariantTsc()) {
+            auto wall0 = std::chrono::steady_clock::now();
+            std::uint64_t tsc0 = __rdtsc();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            std::uint64_t tsc1 = __rdtsc();
+            auto wall1 = std::chrono::steady_clock::now();
+            double ns = std::chrono::duration<double, std::nano>(wall1 - wall0).count();
+            if (tsc1 > tsc0 && ns > 0.0) {
+                c.tsc = true;
+                c.tick0 = tsc0;
+                c.nsPerTick = ns / static_cast<double>(tsc1 - tsc0);
+                return c;
+            }
+        }
+#endif
+        c.tick0 = steadyNs();
+        return c;
+    }
+
+    static const Calibration& calibration() {
+        static const Calibration c = calibrate();
+        return c;
+    }
+
+public:
+    // Raw counter: TSC ticks, or steady_clock nanoseconds on the fallback path.
+    static std::uint64_t ticks() {
+#if FALCONEX_HAS_RDTSC
+        if (calibration().tsc) return __rdtsc();
+#endif
+        return steadyNs();
+    }
+
+    static double nsPerTick() { return calibration().nsPerTick; }
+
+    static bool usingTsc() { return calibration().tsc; }
+
+    // Nanoseconds between two ticks() readings.
+    static long elapsedNs(std::uint64_t from, std::uint64_t to) {
+        return to > from ? static_cast<long>((to - from) * nsPerTick()) : 0;
+    }
+
+    static long nowNs() {
+        thread_local long last = 0;
+        const Calibration& c = calibration();
+        std::uint64_t t = ticks();
+        long ns = t > c.tick0 ? static_cast<long>((t - c.tick0) * c.nsPerTick) : 0;
+        if (ns < last) ns = last;
+        last = ns;
+        return ns;
+    }
+};
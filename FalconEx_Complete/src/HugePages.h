@@ -0,0 +1,155 @@
+#pragma once
+// Memory for the book's nodes (price levels, resting orders, stops, index entries)
+// carved out of 2 MB huge pages, so a large book needs one TLB entry per 2 MB instead
+// of one per 4 KB page. Each 2 MB slab comes from, in order of preference:
+//   1. MAP_HUGETLB - explicit huge pages (needs vm.nr_hugepages reserved),
+//   2. an aligned anonymous mapping with madvise(MADV_HUGEPAGE) - transparent huge
+//      pages, which the kernel may or may not back with a huge page,
+//   3. the upstream resource (ordinary heap).
+// Slabs are prefaulted when mapped, so first touches do not page-fault on the order
+// path. Small blocks are served from per-size free lists; anything larger than
+// kMaxBlock (hash-table bucket arrays) goes straight to the upstream resource.
+//
+// Not synchronized: OrderBook allocates only under bookMutex.
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+enum class PageBacking { HUGETLB, TRANSPARENT, HEAP };
+
+inline const char* pageBackingName(PageBacking backing) {
+    switch (backing) {
+        case PageBacking::HUGETLB: return "hugetlb";
+        case PageBacking::TRANSPARENT: return "transparent huge pages";
+        case PageBacking::HEAP: return "heap";
+    }
+    return "heap";
+}
+
+class HugePageResource : public std::pmr::memory_resource {
+private:
+    static constexpr std::size_t kSlabBytes = 2u << 20;
+    static constexpr std::size_t kGranule = 16;
+    static constexpr std::size_t kMaxBlock = 512;
+
+    struct Slab {
+        void* base;
+        std::size_t bytes;
+        PageBacking backing;
+    };
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    std::pmr::memory_resource* upstream;
+    bool allowHugetlb;
+    std::vector<Slab> slabs;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    FreeBlock* freeLists[kMaxBlock / kGranule + 1] = {};
+    std::size_t slabCount[3] = {};
+
+    void* mapSlab(PageBacking& backing) {
+#ifdef __linux__
+        if (allowHugetlb) {
+            void* p = mmap(nullptr, kSlabBytes, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+            if (p != MAP_FAILED) {
+                backing = PageBacking::HUGETLB;
+                slabs.push_back({p, kSlabBytes, backing});
+                return p;
+            }
+            allowHugetlb = false;  // none reserved; do not retry for every slab
+        }
+        // Over-map by one slab so a 2 MB-aligned window exists, then trim both ends.
+        void* raw = mmap(nullptr, 2 * kSlabBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw != MAP_FAILED) {
+            std::uintptr_t start = reinterpret_cast<std::uintptr_t>(raw);
+            std::uintptr_t aligned = (start + kSlabBytes - 1) & ~(kSlabBytes - 1);
+            if (aligned > start) munmap(raw, aligned - start);
+            std::size_t tail = start + 2 * kSlabBytes - (aligned + kSlabBytes);
+            if (tail > 0) munmap(reinterpret_cast<void*>(aligned + kSlabBytes), tail);
+            void* p = reinterpret_cast<void*>(aligned);
+            madvise(p, kSlabBytes, MADV_HUGEPAGE);
+            for (std::size_t off = 0; off < kSlabBytes; off += 4096) static_cast<volatile char*>(p)[off] = 0;
+            backing = PageBacking::TRANSPARENT;
+            slabs.push_back({p, kSlabBytes, backing});
+            return p;
+        }
+#endif
+        void* p = upstream->allocate(kSlabBytes, kGranule);
+        backing = PageBacking::HEAP;
+        slabs.push_back({p, kSlabBytes, backing});
+        return p;
+    }
+
+    void newSlab() {
+        PageBacking backing;
+        cursor = static_cast<char*>(mapSlab(backing));
+        limit = cursor + kSlabBytes;
+        ++slabCount[static_cast<int>(backing)];
+    }
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        if (bytes > kMaxBlock || alignment > kGranule) return upstream->allocate(bytes, alignment);
+        std::size_t cls = (bytes + kGranule - 1) / kGranule;
+        if (FreeBlock* block = freeLists[cls]) {
+            freeLists[cls] = block->next;
+            return block;
+        }
+        std::size_t size = cls * kGranule;
+        if (static_cast<std::size_t>(limit - cursor) < size) newSlab();
+        void* p = cursor;
+        cursor += size;
+        return p;
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        if (bytes > kMaxBlock || alignment > kGranule) {
+            upstream->deallocate(p, bytes, alignment);
+            return;
+        }
+        std::size_t cls = (bytes + kGranule - 1) / kGranule;
+        freeLists[cls] = new (p) FreeBlock{freeLists[cls]};
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+public:
+    // tryHugetlb = false skips explicit huge pages and goes straight to THP.
+    explicit HugePageResource(bool tryHugetlb = true,
+                              std::pmr::memory_resource* up = std::pmr::new_delete_resource())
+        : upstream(up), allowHugetlb(tryHugetlb) {}
+
+    HugePageResource(const HugePageResource&) = delete;
+    HugePageResource& operator=(const HugePageResource&) = delete;
+
+    ~HugePageResource() override {
+        for (const Slab& s : slabs) {
+#ifdef __linux__
+            if (s.backing != PageBacking::HEAP) {
+                munmap(s.base, s.bytes);
+                continue;
+            }
+#endif
+            upstream->deallocate(s.base, s.bytes, kGranule);
+        }
+    }
+
+    // Slabs mapped so far with the given backing.
+    std::size_t mappedSlabs(PageBacking backing) const { return slabCount[static_cast<int>(backing)]; }
+
+    // Maps the first slab now (off the order path) and reports what backs it.
+    PageBacking reserve() {
+        if (slabs.empty()) newSlab();
+        return slabs.front().backing;
+    }
+};
@@ -0,0 +1,156 @@
+#pragma once
+// Admission control in front of the book: a token bucket per client id and load
+// shedding on the number of in-flight requests. It runs before bookMutex is taken,
+// so a runaway client is turned away without ever contending for the book.
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include "Metrics.h"
+
+enum class IngressResult { ACCEPTED, THROTTLED, SHED };
+
+// Token bucket for one client. Tokens are refilled lazily from the elapsed time on
+// each request, so idle clients cost nothing. Time is passed in (ns) so the same
+// bucket works against the wall clock and the simulated clock.
+class TokenBucket {
+private:
+    std::mutex bucketMutex;
+    double tokens = 0.0;
+    long lastNs = 0;
+    bool primed = false;
+
+public:
+    bool tryConsume(double ratePerSec, double burst, long nowNs) {
+        std::lock_guard<std::mutex> lock(bucketMutex);
+        if (!primed) {
+            tokens = burst;
+            primed = true;
+        } else if (nowNs > lastNs) {
+            tokens = std::min(burst, tokens + (nowNs - lastNs) * 1e-9 * ratePerSec);
+        }
+        lastNs = std::max(lastNs, nowNs);
+        if (tokens < 1.0) return false;
+        tokens -= 1.0;
+        return true;
+    }
+};
+
+struct ThrottleConfig {
+    double ratePerClient = 0.0;  // orders/sec per client, 0 disables throttling
+    double burst = 1.0;          // bucket size in orders
+    int highWatermark = 0;       // in-flight orders at which new orders are shed, 0 disables
+    int lowWatermark = 0;        // shedding stops once depth drains back to this
+};
+
+struct IngressStats {
+    long accepted;
+    long throttled;
+    long shed;
+    long cancels;
+    int depth;
+};
+
+// Cancels bypass both checks because they only ever reduce load.
+class IngressGate {
+private:
+    ThrottleConfig config;
+    std::shared_mutex bucketsMutex;
+    std::unordered_map<int, TokenBucket> buckets;  // one per client id, created on first order
+    std::atomic<int> depth{0};
+    std::atomic<bool> shedding{false};
+    std::atomic<long> accepted{0};
+    std::atomic<long> throttled{0};
+    std::atomic<long> shed{0};
+    std::atomic<long> cancels{0};
+    MetricsPage* metrics = nullptr;
+
+    // Map nodes never move, so a bucket stays valid after the lock is dropped; its own
+    // mutex serializes the client's requests.
+    TokenBucket& bucketFor(int clientId) {
+        {
+            std::shared_lock<std::shared_mutex> lock(bucketsMutex);
+            auto it = buckets.find(clientId);
+            if (it != buckets.end()) return it->second;
+        }
+        std::unique_lock<std::shared_mutex> lock(bucketsMutex);
+        return buckets.try_emplace(clientId).first->second;
+    }
+
+public:
+
+    // Not synchronized with admit(); change settings only while no clients are running.
+    void configure(const ThrottleConfig& c) { config = c; }
+    const ThrottleConfig& settings() const { return config; }
+
+    // Like configure(), only call this before clients start.
+    void attachMetrics(MetricsPage* page) { metrics = page; }
+
+    IngressResult admit(int clientId, long nowNs) {
+        if (config.highWatermark > 0) {
+            int d = depth.load(std::memory_order_relaxed);
+            if (d >= config.highWatermark) shedding.store(true, std::memory_order_relaxed);
+            else if (d <= config.lowWatermark) shedding.store(false, std::memory_order_relaxed);
+            if (shedding.load(std::memory_order_relaxed)) {
+                shed.fetch_add(1, std::memory_order_relaxed);
+                if (metrics) metrics->add(ORDERS_SHED);
+                return IngressResult::SHED;
+            }
+        }
+        if (config.ratePerClient > 0.0) {
+            if (!bucketFor(clientId).tryConsume(config.ratePerClient, config.burst, nowNs)) {
+                throttled.fetch_add(1, std::memory_order_relaxed);
+                if (metrics) metrics->add(ORDERS_THROTTLED);
+                return IngressResult::THROTTLED;
+            }
+        }
+        accepted.fetch_add(1, std::memory_order_relaxed);
+        depth.fetch_add(1, std::memory_order_relaxed);
+        if (metrics) {
+            metrics->add(ORDERS_ACCEPTED);
+            metrics->add(INGRESS_DEPTH);
+        }
+        return IngressResult::ACCEPTED;
+    }
+
+    void admitCancel() {
+        cancels.fetch_add(1, std::memory_order_relaxed);
+        depth.fetch_add(1, std::memory_order_relaxed);
+        if (metrics) {
+            metrics->add(CANCELS);
+            metrics->add(INGRESS_DEPTH);
+        }
+    }
+
+    void release() {
+        depth.fetch_sub(1, std::memory_order_relaxed);
+        if (metrics) metrics->sub(INGRESS_DEPTH);
+    }
+
+    IngressStats stats() const {
+        return {accepted.load(std::memory_order_relaxed), throttled.load(std::memory_order_relaxed),
+                shed.load(std::memory_order_relaxed), cancels.load(std::memory_order_relaxed),
+                depth.load(std::memory_order_relaxed)};
+    }
+
+    void printStats() const {
+        IngressStats s = stats();
+        std::cout << "Accepted: " << s.accepted << " | Throttled: " << s.throttled
+                  << " | Shed: " << s.shed << " | Cancels: " << s.cancels
+                  << " | Queue depth: " << s.depth << std::endl;
+    }
+
+    void exportStats(const std::string& filename) const {
+        IngressStats s = stats();
+        std::ofstream file(filename);
+        file << "accepted " << s.accepted << std::endl;
+        file << "throttled " << s.throttled << std::endl;
+        file << "shed " << s.shed << std::endl;
+        file << "cancels " << s.cancels << std::endl;
+        file << "depth " << s.depth << std::endl;
+    }
+};
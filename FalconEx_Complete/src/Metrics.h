@@ -0,0 +1,186 @@
+#pragma once
+// Live engine metrics. Counters and gauges sit in a fixed-layout page, one per
+// cache line, so engine threads bumping different metrics never share a line. The
+// page is mapped from POSIX shared memory, which lets falconex_stat sample it from
+// another process without touching the engine. All updates are relaxed atomics.
+//
+// The layout is versioned: append new metrics before METRIC_COUNT and bump
+// kMetricsVersion whenever the enum changes.
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+enum Metric : int {
+    ORDERS_ACCEPTED,
+    ORDERS_THROTTLED,
+    ORDERS_SHED,
+    CANCELS,
+    INGRESS_DEPTH,
+    LOCK_ACQUIRED,
+    LOCK_CONTENDED,
+    TRADES,
+    TRADED_QTY,
+    STOPS_TRIGGERED,
+    BID_LEVELS,
+    ASK_LEVELS,
+    RESTING_ORDERS,
+    PENDING_STOPS,
+    REPLICA_LAG_EVENTS,
+    REPLICA_LAG_NS,
+    METRIC_COUNT
+};
+
+struct MetricInfo {
+    const char* name;  // Prometheus name; counters end in _total
+    const char* help;
+    bool gauge;
+};
+
+inline const MetricInfo& metricInfo(Metric m) {
+    static const MetricInfo info[METRIC_COUNT] = {
+        {"falconex_orders_accepted_total", "Orders admitted by the ingress gate", false},
+        {"falconex_orders_throttled_total", "Orders rejected by a client token bucket", false},
+        {"falconex_orders_shed_total", "Orders shed above the queue high watermark", false},
+        {"falconex_cancels_total", "Cancel requests received", false},
+        {"falconex_ingress_depth", "Requests admitted but not yet finished", true},
+        {"falconex_book_lock_acquired_total", "Book mutex acquisitions on the order path", false},
+        {"falconex_book_lock_contended_total", "Acquisitions that found the book mutex held", false},
+        {"falconex_trades_total", "Trades executed", false},
+        {"falconex_traded_quantity_total", "Shares executed", false},
+        {"falconex_stops_triggered_total", "Stop orders triggered", false},
+        {"falconex_bid_levels", "Price levels on the bid side", true},
+        {"falconex_ask_levels", "Price levels on the ask side", true},
+        {"falconex_resting_orders", "Orders resting in the book", true},
+        {"falconex_pending_stops", "Stop orders waiting for their trigger", true},
+        {"falconex_replica_lag_events", "Book events the slowest replica has yet to apply", true},
+        {"falconex_replica_lag_ns", "Publish-to-apply delay of the slowest replica's last batch", true},
+    };
+    return info[m];
+}
+
+constexpr std::uint64_t kMetricsMagic = 0x5343495254454d46ULL;  // "FMETRICS"
+constexpr std::uint32_t kMetricsVersion = 2;
+
+struct alignas(64) MetricCell {
+    std::atomic<std::uint64_t> value{0};
+};
+
+struct MetricsPage {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t count;
+    std::int64_t pid;
+    MetricCell cells[METRIC_COUNT];
+
+    void add(Metric m, std::uint64_t n = 1) { cells[m].value.fetch_add(n, std::memory_order_relaxed); }
+    void sub(Metric m, std::uint64_t n = 1) { cells[m].value.fetch_sub(n, std::memory_order_relaxed); }
+    void set(Metric m, std::uint64_t v) { cells[m].value.store(v, std::memory_order_relaxed); }
+    std::uint64_t get(Metric m) const { return cells[m].value.load(std::memory_order_relaxed); }
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "metrics page needs lock-free 64-bit atomics");
+static_assert(sizeof(MetricCell) == 64, "one metric per cache line");
+
+// Owns the mapping of one metrics page. The engine creates it; readers attach to
+// an existing one read-only. If shared memory is unavailable, create() falls back to
+// a private page so the engine can always update metrics unconditionally.
+class MetricsRegion {
+private:
+    MetricsPage* page = nullptr;
+    std::string name;
+    bool owner = false;
+    bool shared = false;
+
+public:
+    MetricsRegion() = default;
+    MetricsRegion(const MetricsRegion&) = delete;
+    MetricsRegion& operator=(const MetricsRegion&) = delete;
+
+    ~MetricsRegion() {
+        if (!page) return;
+#ifdef __linux__
+        if (shared) {
+            munmap(page, sizeof(MetricsPage));
+            if (owner) shm_unlink(name.c_str());
+            return;
+        }
+#endif
+        page->~MetricsPage();
+        ::operator delete(page, std::align_val_t(alignof(MetricsPage)));
+    }
+
+    // Returns false if the page is private (no shared memory); metrics still work.
+    bool create(const std::string& shmName) {
+        name = shmName;
+        owner = true;
+#ifdef __linux__
+        int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+        if (fd >= 0) {
+            void* mem = MAP_FAILED;
+            if (ftruncate(fd, sizeof(MetricsPage)) == 0) {
+                mem = mmap(nullptr, sizeof(MetricsPage), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            close(fd);
+            if (mem != MAP_FAILED) {
+                page = new (mem) MetricsPage{};
+                shared = true;
+            } else {
+                shm_unlink(name.c_str());
+            }
+        }
+#endif
+        if (!page) {
+            page = new (::operator new(sizeof(MetricsPage), std::align_val_t(alignof(MetricsPage)))) MetricsPage{};
+        }
+        page->count = METRIC_COUNT;
+        page->version = kMetricsVersion;
+#ifdef __linux__
+        page->pid = getpid();
+#endif
+        std::atomic_thread_fence(std::memory_order_release);
+        page->magic = kMetricsMagic;
+        return shared;
+    }
+
+    // Maps an existing page read-only. Fails if it is missing or has another layout.
+    bool attach(const std::string& shmName, std::string& error) {
+        name = shmName;
+#ifdef __linux__
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            error = "no metrics page " + name + " (is falconex running?)";
+            return false;
+        }
+        void* mem = mmap(nullptr, sizeof(MetricsPage), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mem == MAP_FAILED) {
+            error = "cannot map " + name + ": " + std::strerror(errno);
+            return false;
+        }
+        page = static_cast<MetricsPage*>(mem);
+        shared = true;
+        if (page->magic != kMetricsMagic || page->version != kMetricsVersion || page->count != METRIC_COUNT) {
+            error = "metrics page " + name + " has an incompatible layout";
+            return false;
+        }
+        return true;
+#else
+        error = "shared-memory metrics need Linux";
+        return false;
+#endif
+    }
+
+    MetricsPage* get() const { return page; }
+    bool isShared() const { return shared; }
+    const std::string& shmName() const { return name; }
+};
@@ -0,0 +1,818 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "BookFeed.h"
+#include "Metrics.h"
+#include "Threading.h"
+#include "Trace.h"
+#include "TradeTape.h"
+
+enum class OrderType { LIMIT, MARKET, STOP, STOP_LIMIT };
+enum class Side { BUY, SELL };
+
+// Everything that differs between the two sides of the book, as compile-time
+// constants, so side-specific code is instantiated once per side instead of testing
+// order.side on every level and every fill.
+template <Side S>
+struct SideTraits;
+
+template <>
+struct SideTraits<Side::BUY> {
+    using Compare = std::greater<double>;     // best bid first
+    using StopCompare = std::less<double>;    // buy stops fire from the lowest trigger up
+    static constexpr Side opposite = Side::SELL;
+    static constexpr TradeAggressor aggressor = TradeAggressor::BUY;
+    static constexpr double marketPrice = std::numeric_limits<double>::max();
+    static bool crosses(double own, double other) { return own >= other; }
+};
+
+template <>
+struct SideTraits<Side::SELL> {
+    using Compare = std::less<double>;
+    using StopCompare = std::greater<double>;
+    static constexpr Side opposite = Side::BUY;
+    static constexpr TradeAggressor aggressor = TradeAggressor::SELL;
+    static constexpr double marketPrice = std::numeric_limits<double>::lowest();
+    static bool crosses(double own, double other) { return own <= other; }
+};
+
+// Calls fn(std::integral_constant<Side, S>) for the runtime side, so the callee can
+// use S as a template argument.
+template <typename Fn>
+decltype(auto) onSide(Side side, Fn&& fn) {
+    if (side == Side::BUY) return fn(std::integral_constant<Side, Side::BUY>{});
+    return fn(std::integral_constant<Side, Side::SELL>{});
+}
+
+struct Order {
+    int id = 0;
+    std::string symbol;
+    Side side = Side::BUY;
+    OrderType type = OrderType::LIMIT;
+    int quantity = 0;
+    double price = 0.0;
+    long timestamp = 0;
+    int clientId = 0;
+    double stopPrice = 0.0;  // trigger for STOP / STOP_LIMIT, unused otherwise
+    long arrival = 0;        // book-assigned entry sequence, decides which side is resting
+};
+
+// Resting orders of one price level in time priority. Node memory comes from the
+// book's memory resource (see HugePages.h).
+using OrderQueue = std::pmr::list<Order>;
+
+enum class TradingPhase { CONTINUOUS, AUCTION };
+
+struct UncrossResult {
+    double price;   // clearing price, 0 when the book does not cross
+    long volume;    // shares executable at that price
+    long imbalance; // |demand - supply| at that price
+};
+
+struct TopOfBook {
+    double bidPrice;  // 0 when the side is empty
+    long bidQty;
+    double askPrice;
+    long askQty;
+};
+
+struct LevelInfo {
+    double price;
+    long quantity;
+    int orders;
+};
+
+// Matching policies decide how an incoming quantity is shared across the resting
+// orders of the level it hits. They are template parameters of OrderBook, so the
+// FIFO path compiles to a plain front-of-queue loop with no dispatch. Each policy
+// reports fills through onFill (which decrements the order) and removes orders it
+// has emptied after calling onDone; none of them allocate.
+struct FifoMatch {
+    template <typename OnFill, typename OnDone>
+    static void allocate(OrderQueue& orders, long /*levelQty*/, int qty, OnFill&& onFill, OnDone&& onDone) {
+        while (qty > 0) {
+            Order& resting = orders.front();
+            int take = std::min(qty, resting.quantity);
+            onFill(resting, take);
+            qty -= take;
+            if (resting.quantity == 0) {
+                onDone(resting);
+                orders.pop_front();
+            }
+        }
+    }
+};
+
+// Shares proportional to resting size, rounded down; shares below MinAllocation are
+// dropped and whatever is left over goes out in time priority.
+template <int MinAllocation = 1>
+struct ProRataMatch {
+    template <typename OnFill, typename OnDone>
+    static void allocate(OrderQueue& orders, long levelQty, int qty, OnFill&& onFill, OnDone&& onDone) {
+        int remaining = qty;
+        for (auto it = orders.begin(); it != orders.end() && remaining > 0;) {
+            long share = static_cast<long>(qty) * it->quantity / levelQty;
+            if (share < MinAllocation) { ++it; continue; }
+            int take = static_cast<int>(std::min<long>(share, remaining));
+            onFill(*it, take);
+            remaining -= take;
+            if (it->quantity == 0) {
+                onDone(*it);
+                it = orders.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        for (auto it = orders.begin(); it != orders.end() && remaining > 0;) {
+            int take = std::min(remaining, it->quantity);
+            onFill(*it, take);
+            remaining -= take;
+            if (it->quantity == 0) {
+                onDone(*it);
+                it = orders.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+};
+
+// The oldest order at the level is filled first, the remainder is split pro-rata.
+template <int MinAllocation = 1>
+struct TopOrderProRataMatch {
+    template <typename OnFill, typename OnDone>
+    static void allocate(OrderQueue& orders, long levelQty, int qty, OnFill&& onFill, OnDone&& onDone) {
+        Order& top = orders.front();
+        int take = std::min(qty, top.quantity);
+        onFill(top, take);
+        qty -= take;
+        levelQty -= take;
+        if (top.quantity == 0) {
+            onDone(top);
+            orders.pop_front();
+        }
+        if (qty > 0) ProRataMatch<MinAllocation>::allocate(orders, levelQty, qty, onFill, onDone);
+    }
+};
+
+template <typename MatchPolicy = FifoMatch>
+class OrderBook {
+private:
+    struct PriceLevel {
+        using allocator_type = std::pmr::polymorphic_allocator<Order>;
+
+        OrderQueue orders;
+        long totalQty = 0;
+
+        // Allocator-aware, so a level's order nodes come from the same resource as the
+        // map node holding it.
+        explicit PriceLevel(const allocator_type& alloc = {}) : orders(alloc) {}
+        PriceLevel(const PriceLevel& other, const allocator_type& alloc)
+            : orders(other.orders, alloc), totalQty(other.totalQty) {}
+        PriceLevel(PriceLevel&& other, const allocator_type& alloc)
+            : orders(std::move(other.orders), alloc), totalQty(other.totalQty) {}
+    };
+
+    struct OrderLocator {
+        Side side;
+        double price;
+        OrderQueue::iterator it;
+    };
+
+    template <Side S>
+    using Levels = std::pmr::map<double, PriceLevel, typename SideTraits<S>::Compare>;
+    template <Side S>
+    using Stops = std::pmr::multimap<double, Order, typename SideTraits<S>::StopCompare>;
+
+    // Market orders sit at these prices for the one matching pass they get.
+    static constexpr double kMarketBuyPrice = SideTraits<Side::BUY>::marketPrice;
+    static constexpr double kMarketSellPrice = SideTraits<Side::SELL>::marketPrice;
+
+    Levels<Side::BUY> buyOrders;
+    Levels<Side::SELL> sellOrders;
+    std::pmr::unordered_map<int, OrderLocator> orderIndex;
+
+    // Pending stops keyed by trigger price in firing order: buy stops from the lowest
+    // trigger up, sell stops from the highest down. Equal triggers keep arrival order.
+    Stops<Side::BUY> buyStops;
+    Stops<Side::SELL> sellStops;
+    std::pmr::unordered_map<int, std::pair<Side, double>> stopIndex;
+
+    std::mutex bookMutex;
+    std::vector<std::string> tradeLog;
+    TradeTape tape;
+    TradingPhase phase = TradingPhase::CONTINUOUS;
+    double lastTradePrice = 0.0;
+    bool hasTraded = false;
+    double tradeHigh = 0.0;  // traded range since the current matching pass began
+    double tradeLow = 0.0;
+    long nextArrival = 1;
+    long stopsTriggered = 0;
+    bool echoTrades = true;
+    WaitMode waitMode = WaitMode::BLOCK;
+    MetricsPage* metrics = nullptr;
+    BookFeed* feed = nullptr;
+    std::vector<std::pair<Side, double>> touchedLevels;  // since the last batch
+    std::vector<BookEvent> pendingTrades;
+
+    template <Side S>
+    Levels<S>& levels() {
+        if constexpr (S == Side::BUY) return buyOrders; else return sellOrders;
+    }
+
+    template <Side S>
+    Stops<S>& stops() {
+        if constexpr (S == Side::BUY) return buyStops; else return sellStops;
+    }
+
+    // Mutators take the lock through here, waiting as waitMode says, so contention
+    // shows up in the metrics page.
+    std::unique_lock<std::mutex> lockBook() {
+        std::unique_lock<std::mutex> lock(bookMutex, std::defer_lock);
+        if (!metrics && waitMode == WaitMode::BLOCK) {
+            lock.lock();
+            return lock;
+        }
+        bool contended = acquire(lock, waitMode);
+        if (metrics) {
+            if (contended) metrics->add(LOCK_CONTENDED);
+            metrics->add(LOCK_ACQUIRED);
+        }
+        return lock;
+    }
+
+    void touch(Side side, double price) {
+        if (feed) touchedLevels.emplace_back(side, price);
+    }
+
+    template <typename Levels>
+    BookEvent levelEvent(Side side, const Levels& levels, double price) const {
+        auto level = levels.find(price);
+        if (level == levels.end()) return {0, BookEventType::LEVEL, side, 0, price, 0};
+        return {0, BookEventType::LEVEL, side, static_cast<int>(level->second.orders.size()), price,
+                level->second.totalQty};
+    }
+
+    // Called at the end of every locked mutation: refreshes the depth gauges and sends
+    // the touched levels' final state to the replicas as one batch.
+    void publishChanges() {
+        if (metrics) {
+            metrics->set(BID_LEVELS, buyOrders.size());
+            metrics->set(ASK_LEVELS, sellOrders.size());
+            metrics->set(RESTING_ORDERS, orderIndex.size());
+            metrics->set(PENDING_STOPS, stopIndex.size());
+        }
+        if (!feed || (touchedLevels.empty() && pendingTrades.empty())) return;
+        for (const BookEvent& trade : pendingTrades) feed->publish(trade);
+        std::sort(touchedLevels.begin(), touchedLevels.end());
+        touchedLevels.erase(std::unique(touchedLevels.begin(), touchedLevels.end()), touchedLevels.end());
+        for (auto [side, price] : touchedLevels) {
+            if (price == kMarketBuyPrice || price == kMarketSellPrice) continue;
+            feed->publish(onSide(side, [&](auto s) { return levelEvent(s, levels<s>(), price); }));
+        }
+        pendingTrades.clear();
+        touchedLevels.clear();
+        feed->endBatch();
+    }
+
+    template <typename Levels>
+    static void eraseFromLevel(Levels& levels, double price, OrderQueue::iterator it) {
+        auto level = levels.find(price);
+        level->second.totalQty -= it->quantity;
+        level->second.orders.erase(it);
+        if (level->second.orders.empty()) levels.erase(level);
+    }
+
+    template <typename Levels>
+    void dropLevel(Levels& levels, typename Levels::iterator level) {
+        for (const auto& o : level->second.orders) orderIndex.erase(o.id);
+        levels.erase(level);
+    }
+
+    template <typename Stops>
+    static void eraseStop(Stops& stops, double trigger, int orderId) {
+        auto [first, last] = stops.equal_range(trigger);
+        for (auto it = first; it != last; ++it) {
+            if (it->second.id == orderId) {
+                stops.erase(it);
+                return;
+            }
+        }
+    }
+
+    template <typename Stops>
+    static Order popStop(Stops& stops) {
+        Order o = std::move(stops.begin()->second);
+        stops.erase(stops.begin());
+        return o;
+    }
+
+    template <Side S>
+    void restOrder(Order order) {
+        if (order.type == OrderType::MARKET) order.price = SideTraits<S>::marketPrice;
+        order.arrival = nextArrival++;
+        auto& level = levels<S>()[order.price];
+        touch(S, order.price);
+        level.orders.push_back(order);
+        level.totalQty += order.quantity;
+        orderIndex[order.id] = {S, order.price, std::prev(level.orders.end())};
+    }
+
+    void restOrder(Order order) {
+        onSide(order.side, [&](auto s) { restOrder<s>(std::move(order)); });
+    }
+
+    // Takes qty off the front order of a level, dropping the order and the level once empty.
+    template <typename Levels>
+    void fillFront(Levels& levels, typename Levels::iterator level, int qty) {
+        Order& front = level->second.orders.front();
+        front.quantity -= qty;
+        level->second.totalQty -= qty;
+        if (front.quantity == 0) {
+            orderIndex.erase(front.id);
+            level->second.orders.pop_front();
+            if (level->second.orders.empty()) levels.erase(level);
+        }
+    }
+
+    // Matching kernel, instantiated per aggressor side and order type: the front order
+    // of S's best level walks the opposite side's levels, best first, for as long as it
+    // has quantity, the price crosses (never checked for MARKET, whose sentinel price
+    // crosses everything) and the level it meets was there before it. The policy decides
+    // which resting orders at each level receive the fills. The aggressor is charged
+    // once at the end, so the loop touches only the passive side.
+    template <Side S, OrderType T>
+    void sweepOrder() {
+        constexpr Side P = SideTraits<S>::opposite;
+        Levels<S>& own = levels<S>();
+        Levels<P>& passive = levels<P>();
+        auto ownLevel = own.begin();
+        Order& aggressor = ownLevel->second.orders.front();
+        int remaining = aggressor.quantity;
+
+        while (remaining > 0 && !passive.empty()) {
+            auto level = passive.begin();
+            if constexpr (T != OrderType::MARKET) {
+                if (!SideTraits<S>::crosses(ownLevel->first, level->first)) break;
+            }
+            PriceLevel& resting = level->second;
+            if (resting.orders.front().arrival > aggressor.arrival) break;
+            FALCONEX_TRACE_COUNT(levels);
+
+            double price = level->first;
+            int qty = static_cast<int>(std::min<long>(remaining, resting.totalQty));
+            touch(P, price);
+            MatchPolicy::allocate(resting.orders, resting.totalQty, qty,
+                [&](Order& o, int fill) {
+                    if constexpr (S == Side::BUY) {
+                        recordTrade(aggressor, o, fill, price, SideTraits<S>::aggressor, aggressor.timestamp);
+                    } else {
+                        recordTrade(o, aggressor, fill, price, SideTraits<S>::aggressor, aggressor.timestamp);
+                    }
+                    o.quantity -= fill;
+                    resting.totalQty -= fill;
+                },
+                [&](const Order& o) { orderIndex.erase(o.id); });
+            if (resting.orders.empty()) passive.erase(level);
+            remaining -= qty;
+        }
+
+        int filled = aggressor.quantity - remaining;
+        if (filled > 0) {
+            touch(S, ownLevel->first);
+            fillFront(own, ownLevel, filled);
+        }
+    }
+
+    template <Side S>
+    void sweepFrom() {
+        if (levels<S>().begin()->first == SideTraits<S>::marketPrice) {
+            sweepOrder<S, OrderType::MARKET>();
+        } else {
+            sweepOrder<S, OrderType::LIMIT>();
+        }
+    }
+
+    void recordTrade(const Order& buy, const Order& sell, int qty, double price, TradeAggressor aggressor, long ts) {
+        FALCONEX_TRACE_COUNT(trades);
+        tape.append(ts, price, qty, aggressor, buy.id, sell.id);
+        std::stringstream log;
+        log << "TRADE: " << qty << " shares of " << buy.symbol
+            << " at $" << std::fixed << std::setprecision(2) << price;
+        tradeLog.push_back(log.str());
+        if (echoTrades) std::cout << log.str() << std::endl;
+        if (metrics) {
+            metrics->add(TRADES);
+            metrics->add(TRADED_QTY, qty);
+        }
+        if (feed) pendingTrades.push_back({0, BookEventType::TRADE, Side::BUY, 0, price, qty});
+        lastTradePrice = price;
+        if (!hasTraded) {
+            hasTraded = true;
+            tradeHigh = tradeLow = price;
+        } else {
+            tradeHigh = std::max(tradeHigh, price);
+            tradeLow = std::min(tradeLow, price);
+        }
+    }
+
+    void matchBook() {
+        while (!buyOrders.empty() && !sellOrders.empty()) {
+            auto highestBuy = buyOrders.begin();
+            auto lowestSell = sellOrders.begin();
+
+            if (highestBuy->first < lowestSell->first) break;
+            // The book was uncrossed before the latest arrival, so whichever side's front
+            // order entered first is the one resting, and sets the price.
+            if (highestBuy->second.orders.front().arrival < lowestSell->second.orders.front().arrival) {
+                sweepFrom<Side::SELL>();
+            } else {
+                sweepFrom<Side::BUY>();
+            }
+        }
+
+        // Market orders never rest: whatever the other side could not fill is cancelled.
+        if (!buyOrders.empty() && buyOrders.begin()->first == kMarketBuyPrice) {
+            dropLevel(buyOrders, buyOrders.begin());
+        }
+        if (!sellOrders.empty() && sellOrders.begin()->first == kMarketSellPrice) {
+            dropLevel(sellOrders, sellOrders.begin());
+        }
+    }
+
+    // Pops stops whose trigger lies inside the traded range, one at a time in trigger-book
+    // order. Each fired stop re-enters as a market or limit order and is matched before
+    // the next is considered, so cascades are deterministic and only triggered stops are
+    // ever touched.
+    void triggerStops() {
+        while (hasTraded) {
+            Order fired;
+            if (!buyStops.empty() && buyStops.begin()->first <= tradeHigh) {
+                fired = popStop(buyStops);
+            } else if (!sellStops.empty() && sellStops.begin()->first >= tradeLow) {
+                fired = popStop(sellStops);
+            } else {
+                break;
+            }
+            stopIndex.erase(fired.id);
+            fired.type = fired.type == OrderType::STOP ? OrderType::MARKET : OrderType::LIMIT;
+            ++stopsTriggered;
+            if (metrics) metrics->add(STOPS_TRIGGERED);
+            restOrder(std::move(fired));
+            matchBook();
+        }
+    }
+
+    // One ascending merge over both sides' level aggregates. Demand at p is every buy
+    // priced >= p, supply every sell priced <= p; the best price maximises
+    // std::min(demand, supply), then minimises the imbalance. Among tied levels it is
+    // the one closest to the last trade (the lower one if two are equally close), or
+    // the middle one (lower middle) when nothing has traded yet; always an entered price.
+    UncrossResult computeUncross() const {
+        UncrossResult best{0.0, 0, 0};
+        if (buyOrders.empty() || sellOrders.empty()) return best;
+        double lo = sellOrders.begin()->first;
+        double hi = buyOrders.begin()->first;
+        if (hi < lo) return best;
+
+        long totalDemand = 0;
+        for (const auto& [price, level] : buyOrders) totalDemand += level.totalQty;
+
+        auto buyIt = buyOrders.rbegin();
+        auto sellIt = sellOrders.begin();
+        long demandBelow = 0;  // buy qty priced strictly below the candidate
+        long supply = 0;       // sell qty priced at or below the candidate
+        std::vector<double> tied;  // ascending level prices sharing the best volume and imbalance
+
+        while (buyIt != buyOrders.rend() || sellIt != sellOrders.end()) {
+            double p;
+            if (sellIt == sellOrders.end() || (buyIt != buyOrders.rend() && buyIt->first < sellIt->first)) {
+                p = buyIt->first;
+            } else {
+                p = sellIt->first;
+            }
+            if (p > hi) break;
+
+            long levelDemand = 0;
+            if (buyIt != buyOrders.rend() && buyIt->first == p) levelDemand = (buyIt++)->second.totalQty;
+            if (sellIt != sellOrders.end() && sellIt->first == p) supply += (sellIt++)->second.totalQty;
+
+            if (p >= lo && p != kMarketBuyPrice && p != kMarketSellPrice) {
+                long demand = totalDemand - demandBelow;
+                long volume = std::min(demand, supply);
+                long imbalance = demand > supply ? demand - supply : supply - demand;
+                if (volume > best.volume || (volume == best.volume && imbalance < best.imbalance)) {
+                    best = {p, volume, imbalance};
+                    tied.assign(1, p);
+                } else if (volume == best.volume && imbalance == best.imbalance) {
+                    tied.push_back(p);
+                }
+            }
+            demandBelow += levelDemand;
+        }
+
+        if (tied.size() > 1) {
+            if (lastTradePrice > 0.0) {
+                for (double p : tied) {
+                    if (std::abs(p - lastTradePrice) < std::abs(best.price - lastTradePrice)) best.price = p;
+                }
+            } else {
+                best.price = tied[(tied.size() - 1) / 2];
+            }
+        }
+        return best;
+    }
+
+public:
+    // Levels, orders, stops and index entries are allocated from `memory` (e.g. a
+    // HugePageResource), which must outlive the book.
+    explicit OrderBook(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+        : buyOrders(memory), sellOrders(memory), orderIndex(memory), buyStops(memory), sellStops(memory),
+          stopIndex(memory) {}
+
+    // How mutators wait for a contended book lock. Set before other threads use the book.
+    void setWaitMode(WaitMode mode) { waitMode = mode; }
+
+    void addOrder(const Order& order) {
+        FALCONEX_TRACE_SCOPE(ADD_ORDER);  // includes the lock wait, traced inside it
+        FALCONEX_TRACE_START(lockStart);
+        auto lock = lockBook();
+        FALCONEX_TRACE_STOP(LOCK_WAIT, lockStart);
+
+        onSide(order.side, [&](auto s) {
+            if (order.type == OrderType::STOP || order.type == OrderType::STOP_LIMIT) {
+                stops<s>().emplace(order.stopPrice, order);
+                stopIndex[order.id] = {s, order.stopPrice};
+            } else {
+                restOrder<s>(order);
+            }
+        });
+        publishChanges();
+    }
+
+    bool cancelOrder(int orderId) {
+        auto lock = lockBook();
+
+        auto found = orderIndex.find(orderId);
+        if (found == orderIndex.end()) {
+            auto stop = stopIndex.find(orderId);
+            if (stop == stopIndex.end()) return false;
+            auto [side, trigger] = stop->second;
+            onSide(side, [&](auto s) { eraseStop(stops<s>(), trigger, orderId); });
+            stopIndex.erase(stop);
+            publishChanges();
+            return true;
+        }
+        const OrderLocator& loc = found->second;
+        touch(loc.side, loc.price);
+        onSide(loc.side, [&](auto s) { eraseFromLevel(levels<s>(), loc.price, loc.it); });
+        orderIndex.erase(found);
+        publishChanges();
+        return true;
+    }
+
+    // A size reduction at the same price keeps queue position; any other change is a
+    // cancel/replace to the back of the new level. Follow a price change with
+    // matchOrders() in case the order now crosses.
+    bool modifyOrder(int orderId, double newPrice, int newQty) {
+        auto lock = lockBook();
+
+        auto found = orderIndex.find(orderId);
+        if (found == orderIndex.end() || newQty <= 0) return false;
+        OrderLocator& loc = found->second;
+        touch(loc.side, loc.price);
+        if (newPrice == loc.price && newQty <= loc.it->quantity) {
+            PriceLevel& level = onSide(loc.side, [&](auto s) -> PriceLevel& { return levels<s>().find(loc.price)->second; });
+            level.totalQty -= loc.it->quantity - newQty;
+            loc.it->quantity = newQty;
+            publishChanges();
+            return true;
+        }
+
+        Order replaced = *loc.it;
+        onSide(loc.side, [&](auto s) { eraseFromLevel(levels<s>(), loc.price, loc.it); });
+        orderIndex.erase(found);
+        replaced.price = newPrice;
+        replaced.quantity = newQty;
+        restOrder(replaced);
+        publishChanges();
+        return true;
+    }
+
+    void matchOrders() {
+        FALCONEX_TRACE_SCOPE(MATCH_ORDERS);  // includes the lock wait, traced inside it
+        FALCONEX_TRACE_START(lockStart);
+        auto lock = lockBook();
+        FALCONEX_TRACE_STOP(LOCK_WAIT, lockStart);
+        if (phase == TradingPhase::AUCTION) return;
+
+        tradeHigh = tradeLow = lastTradePrice;
+        matchBook();
+        triggerStops();
+        publishChanges();
+    }
+
+    TopOfBook topOfBook() {
+        std::lock_guard<std::mutex> lock(bookMutex);
+        TopOfBook top{0.0, 0, 0.0, 0};
+        if (!buyOrders.empty()) {
+            top.bidPrice = buyOrders.begin()->first;
+            top.bidQty = buyOrders.begin()->second.totalQty;
+        }
+        if (!sellOrders.empty()) {
+            top.askPrice = sellOrders.begin()->first;
+            top.askQty = sellOrders.begin()->second.totalQty;
+        }
+        return top;
+    }
+
+    // Runs fn(TradeTape&) under the book lock, e.g. to read bars or rolling windows, or
+    // to configure them. Keep fn short: matching waits for it.
+    template <typename Fn>
+    auto withTape(Fn&& fn) {
+        std::lock_guard<std::mutex> lock(bookMutex);
+        return fn(tape);
+    }
+
+    // Unfilled quantity of a resting order, 0 once it has traded out or been cancelled.
+    int restingQuantity(int orderId) {
+        std::lock_guard<std::mutex> lock(bookMutex);
+        auto found = orderIndex.find(orderId);
+        return found == orderIndex.end() ? 0 : found->second.it->quantity;
+    }
+
+    // The best `levels` price levels of one side, best first.
+    std::vector<LevelInfo> depth(Side side, int levels) {
+        std::lock_guard<std::mutex> lock(bookMutex);
+        std::vector<LevelInfo> out;
+        onSide(side, [&](auto s) {
+            const auto& book = this->levels<s>();
+            for (auto it = book.begin(); it != book.end() && static_cast<int>(out.size()) < levels; ++it) {
+                out.push_back({it->first, it->second.totalQty, static_cast<int>(it->second.orders.size())});
+            }
+        });
+        return out;
+    }
+
+    void clearTradeLog() {
+        std::lock_guard<std::mutex> lock(bookMutex);
+        tradeLog.clear();
+    }
+
+    void setTradeEcho(bool on) {
+        std::lock_guard<std::mutex> lock(bookMutex);
+        echoTrades = on;
+    }
+
+    // Counters and depth gauges go to this page from now on; nullptr detaches.
+    void attachMetrics(MetricsPage* page) {
+        std::lock_guard<std::mutex> lock(bookMutex);
+        metrics = page;
+        publishChanges();
+    }
+
+    // Book changes are published to this feed's subscribers from now on. Subscribe
+    // every replica first, then attach; each replica starts from republish().
+    void attachFeed(BookFeed* f) {
+        std::lock_guard<std::mutex> lock(bookMutex);
+        feed = f;
+    }
+
+    // Restarts one subscriber from a full snapshot: CLEAR, every level, BATCH_END, all
+    // stamped with the current sequence. Replicas call this at start-up and after
+    // losing events, from their own thread, so the ring can be resized here.
+    void republish(std::size_t subscriber) {
+        std::lock_guard<std::mutex> lock(bookMutex);
+        if (!feed) return;
+        BookEventRing& ring = feed->ring(subscriber);
+        ring.reset();
+        // A snapshot that overflowed would only be requested again, forever. Leave as
+        // much room again for the live batches that follow it while it is applied.
+        ring.reserve(2 * (buyOrders.size() + sellOrders.size() + 2));
+        std::uint64_t seq = feed->published();
+        ring.push({seq, BookEventType::CLEAR, Side::BUY, 0, 0.0, 0});
+        auto snapshot = [&](Side side, const auto& levels) {
+            for (const auto& [price, level] : levels) {
+                if (price == kMarketBuyPrice || price == kMarketSellPrice) continue;
+                if (!ring.push({seq, BookEventType::LEVEL, side, static_cast<int>(level.orders.size()), price,
+                                level.totalQty})) {
+                    ring.markLost();
+                    return;
+                }
+            }
+        };
+        snapshot(Side::BUY, buyOrders);
+        snapshot(Side::SELL, sellOrders);
+        if (!ring.push({seq, BookEventType::BATCH_END, Side::BUY, 0, 0.0, TscClock::nowNs()})) ring.markLost();
+    }
+
+    long triggeredStops() {
+        std::lock_guard<std::mutex> lock(bookMutex);
+        return stopsTriggered;
+    }
+
+    std::size_t tradeCount() {
+        std::lock_guard<std::mutex> lock(bookMutex);
+        return tradeLog.size();
+    }
+
+    // FNV-1a over the trade log; equal checksums mean identical trade sequences.
+    std::uint64_t tradeLogChecksum() {
+        std::lock_guard<std::mutex> lock(bookMutex);
+        std::uint64_t h = 1469598103934665603ULL;
+        for (const auto& entry : tradeLog) {
+            for (unsigned char c : entry) {
+                h ^= c;
+                h *= 1099511628211ULL;
+            }
+            h ^= '\n';
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+
+    // Starts a call period: orders rest without matching until uncross().
+    void beginAuction() {
+        std::lock_guard<std::mutex> lock(bookMutex);
+        phase = TradingPhase::AUCTION;
+    }
+
+    TradingPhase tradingPhase() {
+        std::lock_guard<std::mutex> lock(bookMutex);
+        return phase;
+    }
+
+    UncrossResult indicativeUncross() {
+        std::lock_guard<std::mutex> lock(bookMutex);
+        return computeUncross();
+    }
+
+    // Executes the whole crossed volume at the single clearing price, allocating in
+    // price-time priority, and returns the book to continuous trading.
+    UncrossResult uncross() {
+        std::lock_guard<std::mutex> lock(bookMutex);
+        UncrossResult result = computeUncross();
+        tradeHigh = tradeLow = lastTradePrice;
+
+        long remaining = result.volume;
+        while (remaining > 0) {
+            auto highestBuy = buyOrders.begin();
+            auto lowestSell = sellOrders.begin();
+            const Order& buyOrder = highestBuy->second.orders.front();
+            const Order& sellOrder = lowestSell->second.orders.front();
+
+            int tradedQty = static_cast<int>(std::min<long>(remaining, std::min(buyOrder.quantity, sellOrder.quantity)));
+            touch(Side::BUY, highestBuy->first);
+            touch(Side::SELL, lowestSell->first);
+            recordTrade(buyOrder, sellOrder, tradedQty, result.price, TradeAggressor::AUCTION,
+                        std::max(buyOrder.timestamp, sellOrder.timestamp));
+            remaining -= tradedQty;
+
+            fillFront(buyOrders, highestBuy, tradedQty);
+            fillFront(sellOrders, lowestSell, tradedQty);
+        }
+
+        phase = TradingPhase::CONTINUOUS;
+        matchBook();
+        triggerStops();
+        publishChanges();
+        return result;
+    }
+
+    void printBook() {
+        std::lock_guard<std::mutex> lock(bookMutex);
+        std::cout << "\nOrder Book Snapshot:" << std::endl;
+        std::cout << "BUY SIDE:" << std::endl;
+        for (auto& [price, level] : buyOrders) {
+            std::cout << "Price: $" << price << " Qty: " << level.orders.front().quantity << std::endl;
+        }
+        std::cout << "SELL SIDE:" << std::endl;
+        for (auto& [price, level] : sellOrders) {
+            std::cout << "Price: $" << price << " Qty: " << level.orders.front().quantity << std::endl;
+        }
+        std::cout << "STOPS: " << buyStops.size() << " buy / " << sellStops.size() << " sell pending" << std::endl;
+    }
+
+    void exportLog(const std::string& filename) {
+        std::ofstream file(filename);
+        for (const auto& entry : tradeLog) {
+            file << entry << std::endl;
+        }
+        file.close();
+    }
+};
@@ -0,0 +1,228 @@
+#pragma once
+// Read-only copy of the primary book's price levels, maintained on its own thread from
+// a BookFeed subscription. Queries lock only the replica, so depth requests, snapshots
+// and analytics never contend with matching for bookMutex. A replica that misses
+// events (sequence gap or ring overflow) asks the primary for a fresh snapshot.
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "BookFeed.h"
+#include "Metrics.h"
+#include "OrderBook.h"
+#include "Threading.h"
+
+struct ReplicaStats {
+    std::uint64_t appliedSeq;
+    std::uint64_t lagEvents;  // published but not yet applied, as of the last batch
+    std::uint64_t lagNs;      // publish-to-apply delay of the last batch
+    long resyncs;
+    long trades;
+    long volume;
+    double vwap;
+    double lastPrice;
+};
+
+class ReplicaBook {
+private:
+    struct Level {
+        long qty;
+        int orders;
+    };
+
+    enum class SyncState { WAIT_CLEAR, SNAPSHOT, LIVE };
+
+    BookFeed& feed;
+    const std::size_t subscriber;
+    std::function<void(std::size_t)> requestSnapshot;
+    MetricsPage* metrics;
+    WaitMode idleMode;
+    int cpu;
+
+    mutable std::mutex replicaMutex;
+    std::map<double, Level, std::greater<double>> bids;
+    std::map<double, Level> asks;
+    SyncState state = SyncState::WAIT_CLEAR;
+    std::uint64_t appliedSeq = 0;
+    std::uint64_t lagEvents = 0;
+    std::uint64_t lagNs = 0;
+    long resyncs = 0;
+    long trades = 0;
+    long volume = 0;
+    double notional = 0.0;
+    double lastPrice = 0.0;
+
+    std::atomic<bool> stopping{false};
+    std::thread worker;
+
+    void resync() {
+        {
+            std::lock_guard<std::mutex> lock(replicaMutex);
+            state = SyncState::WAIT_CLEAR;
+            ++resyncs;
+        }
+        requestSnapshot(subscriber);
+    }
+
+    void setLevel(const BookEvent& e) {
+        auto update = [&](auto& levels) {
+            if (e.orders == 0) levels.erase(e.price);
+            else levels[e.price] = {e.qty, e.orders};
+        };
+        if (e.side == Side::BUY) update(bids); else update(asks);
+    }
+
+    void finishBatch(const BookEvent& end) {
+        appliedSeq = end.seq;
+        long now = TscClock::nowNs();
+        lagNs = now > end.qty ? static_cast<std::uint64_t>(now - end.qty) : 0;
+        std::uint64_t published = feed.published();
+        lagEvents = published > appliedSeq ? published - appliedSeq : 0;
+        feed.reportLag(subscriber, lagEvents, lagNs);
+        if (metrics) {
+            metrics->set(REPLICA_LAG_EVENTS, feed.maxLagEvents());
+            metrics->set(REPLICA_LAG_NS, feed.maxLagNs());
+        }
+    }
+
+    // Returns false on a sequence gap.
+    bool apply(const BookEvent& e) {
+        if (e.type == BookEventType::CLEAR) {
+            bids.clear();
+            asks.clear();
+            state = SyncState::SNAPSHOT;
+            return true;
+        }
+        if (state == SyncState::WAIT_CLEAR) return true;
+        if (state == SyncState::LIVE && e.seq != appliedSeq + 1) return false;
+        if (state == SyncState::LIVE) appliedSeq = e.seq;
+
+        switch (e.type) {
+            case BookEventType::LEVEL:
+                setLevel(e);
+                break;
+            case BookEventType::TRADE:
+                ++trades;
+                volume += e.qty;
+                notional += e.price * e.qty;
+                lastPrice = e.price;
+                break;
+            case BookEventType::BATCH_END:
+                state = SyncState::LIVE;
+                finishBatch(e);
+                break;
+            case BookEventType::CLEAR:
+                break;
+        }
+        return true;
+    }
+
+    // Applies `first` and the rest of its batch under the replica lock, so readers only
+    // ever see the book between batches. Returns false if the replica must resync.
+    bool applyBatch(BookEventRing& ring, BookEvent e) {
+        std::lock_guard<std::mutex> lock(replicaMutex);
+        while (true) {
+            if (!apply(e)) {
+                state = SyncState::WAIT_CLEAR;
+                return false;
+            }
+            if (e.type == BookEventType::BATCH_END) return true;
+            while (!ring.pop(e)) {
+                if (ring.lost() || stopping.load(std::memory_order_relaxed)) return !ring.lost();
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void run() {
+        if (cpu >= 0 && !pinThisThread(cpu)) {
+            std::cerr << "replica " << subscriber << ": cannot pin to CPU " << cpu << "\n";
+        }
+        resync();
+        BookEventRing& ring = feed.ring(subscriber);
+        BookEvent e;
+        IdleWait idle(idleMode);
+        while (!stopping.load(std::memory_order_relaxed)) {
+            if (ring.lost()) {
+                resync();
+                continue;
+            }
+            if (!ring.pop(e)) {
+                idle.wait();
+                continue;
+            }
+            idle.reset();
+            if (!applyBatch(ring, e)) resync();
+        }
+    }
+
+public:
+    // requestSnapshot(subscriber) must make the primary republish to this subscriber.
+    // The thread waits for events as `idle` says and is pinned to `cpuId` if >= 0.
+    ReplicaBook(BookFeed& bookFeed, std::size_t sub, std::function<void(std::size_t)> snapshot,
+                MetricsPage* page = nullptr, WaitMode idle = WaitMode::SPIN_THEN_PARK, int cpuId = -1)
+        : feed(bookFeed), subscriber(sub), requestSnapshot(std::move(snapshot)), metrics(page), idleMode(idle),
+          cpu(cpuId) {}
+
+    ~ReplicaBook() { stop(); }
+
+    void start() {
+        worker = std::thread([this] { run(); });
+    }
+
+    void stop() {
+        stopping.store(true, std::memory_order_relaxed);
+        if (worker.joinable()) worker.join();
+    }
+
+    TopOfBook topOfBook() const {
+        std::lock_guard<std::mutex> lock(replicaMutex);
+        TopOfBook top{0.0, 0, 0.0, 0};
+        if (!bids.empty()) {
+            top.bidPrice = bids.begin()->first;
+            top.bidQty = bids.begin()->second.qty;
+        }
+        if (!asks.empty()) {
+            top.askPrice = asks.begin()->first;
+            top.askQty = asks.begin()->second.qty;
+        }
+        return top;
+    }
+
+    // The best `levels` price levels of one side, best first.
+    std::vector<LevelInfo> depth(Side side, int levels) const {
+        std::lock_guard<std::mutex> lock(replicaMutex);
+        std::vector<LevelInfo> out;
+        auto collect = [&](const auto& book) {
+            for (auto it = book.begin(); it != book.end() && static_cast<int>(out.size()) < levels; ++it) {
+                out.push_back({it->first, it->second.qty, it->second.orders});
+            }
+        };
+        if (side == Side::BUY) collect(bids); else collect(asks);
+        return out;
+    }
+
+    ReplicaStats stats() const {
+        std::lock_guard<std::mutex> lock(replicaMutex);
+        return {appliedSeq, lagEvents, lagNs, resyncs, trades, volume,
+                volume > 0 ? notional / volume : 0.0, lastPrice};
+    }
+
+    void printBook() const {
+        std::lock_guard<std::mutex> lock(replicaMutex);
+        std::cout << "\nOrder Book Snapshot (replica " << subscriber << ", seq " << appliedSeq
+                  << (state == SyncState::LIVE ? "" : ", resyncing") << "):" << std::endl;
+        std::cout << "BUY SIDE:" << std::endl;
+        for (const auto& [price, level] : bids) {
+            std::cout << "Price: $" << price << " Qty: " << level.qty << " (" << level.orders << " orders)" << std::endl;
+        }
+        std::cout << "SELL SIDE:" << std::endl;
+        for (const auto& [price, level] : asks) {
+            std::cout << "Price: $" << price << " Qty: " << level.qty << " (" << level.orders << " orders)" << std::endl;
+        }
+    }
+};
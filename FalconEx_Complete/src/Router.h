@@ -0,0 +1,233 @@
+#pragma once
+// Smart order routing across several venues trading the same symbol. Each venue is
+// either an in-process OrderBook or an external venue known only by the top of book
+// it publishes (fed in through onQuote()). The router keeps the consolidated BBO up to
+// date on every quote change with one pass over the venues, and splits aggressive
+// orders across venues by price, available size and simulated venue latency.
+//
+// Not thread-safe: drive a Router from one thread.
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "OrderBook.h"
+
+struct VenueConfig {
+    std::string name;
+    long latencyNs = 0;  // one-way router-to-venue latency
+};
+
+// Quantities are summed over every venue quoting the best price; the venue is the
+// fastest of them, or -1 when no venue quotes that side.
+struct ConsolidatedBbo {
+    double bidPrice;
+    long bidQty;
+    int bidVenue;
+    double askPrice;
+    long askQty;
+    int askVenue;
+};
+
+struct ChildOrder {
+    int venue;
+    double price;    // limit: the worst level the plan takes on this venue
+    int quantity;
+    long arrivalNs;  // when the child reaches the venue
+    int filled;      // set by route() for in-process venues
+    double notional;
+};
+
+struct RouteResult {
+    std::vector<ChildOrder> children;
+    int filled;
+    double avgPrice;
+};
+
+template <typename MatchPolicy = FifoMatch>
+class Router {
+private:
+    struct Venue {
+        VenueConfig config;
+        std::unique_ptr<OrderBook<MatchPolicy>> book;  // null for external venues
+        TopOfBook quote{0.0, 0, 0.0, 0};
+    };
+
+    std::vector<Venue> venues;
+    ConsolidatedBbo bbo{0.0, 0, -1, 0.0, 0, -1};
+    std::string symbol;
+    double latencyPenaltyBpsPerUs = 0.0;
+    int planDepth = 10;
+    int nextChildId = 1 << 30;  // above ids handed out by the engines feeding the books
+    long quoteUpdates = 0;
+
+    static bool marketable(Side side, double price, double limitPrice) {
+        return side == Side::BUY ? price <= limitPrice : price >= limitPrice;
+    }
+
+    // One pass over the venues' cached quotes.
+    void recomputeBbo() {
+        ConsolidatedBbo best{0.0, 0, -1, 0.0, 0, -1};
+        for (int v = 0; v < static_cast<int>(venues.size()); ++v) {
+            const TopOfBook& q = venues[v].quote;
+            long latency = venues[v].config.latencyNs;
+            if (q.bidQty > 0) {
+                if (best.bidVenue < 0 || q.bidPrice > best.bidPrice) {
+                    best.bidPrice = q.bidPrice;
+                    best.bidQty = q.bidQty;
+                    best.bidVenue = v;
+                } else if (q.bidPrice == best.bidPrice) {
+                    best.bidQty += q.bidQty;
+                    if (latency < venues[best.bidVenue].config.latencyNs) best.bidVenue = v;
+                }
+            }
+            if (q.askQty > 0) {
+                if (best.askVenue < 0 || q.askPrice < best.askPrice) {
+                    best.askPrice = q.askPrice;
+                    best.askQty = q.askQty;
+                    best.askVenue = v;
+                } else if (q.askPrice == best.askPrice) {
+                    best.askQty += q.askQty;
+                    if (latency < venues[best.askVenue].config.latencyNs) best.askVenue = v;
+                }
+            }
+        }
+        bbo = best;
+    }
+
+    // Liquidity a venue offers to an aggressor on `side`, best first.
+    std::vector<LevelInfo> liquidity(const Venue& venue, Side side) const {
+        Side passive = side == Side::BUY ? Side::SELL : Side::BUY;
+        if (venue.book) return venue.book->depth(passive, planDepth);
+        const TopOfBook& q = venue.quote;
+        if (passive == Side::SELL && q.askQty > 0) return {{q.askPrice, q.askQty, 1}};
+        if (passive == Side::BUY && q.bidQty > 0) return {{q.bidPrice, q.bidQty, 1}};
+        return {};
+    }
+
+public:
+    explicit Router(std::string sym = "AAPL") : symbol(std::move(sym)) {}
+
+    // Each microsecond of venue latency makes a level look this many bps worse when
+    // ranking, so a slightly better price on a slow venue can lose to a fast one.
+    void setLatencyPenalty(double bpsPerUs) { latencyPenaltyBpsPerUs = bpsPerUs; }
+
+    // Levels per venue considered when planning.
+    void setPlanDepth(int levels) { planDepth = levels; }
+
+    int addVenue(const VenueConfig& config) {
+        venues.push_back({config, std::make_unique<OrderBook<MatchPolicy>>()});
+        venues.back().book->setTradeEcho(false);
+        return static_cast<int>(venues.size()) - 1;
+    }
+
+    // A venue the router cannot see into; keep it current with onQuote().
+    int addExternalVenue(const VenueConfig& config) {
+        venues.push_back({config, nullptr});
+        return static_cast<int>(venues.size()) - 1;
+    }
+
+    int venueCount() const { return static_cast<int>(venues.size()); }
+    const VenueConfig& venue(int v) const { return venues[v].config; }
+    OrderBook<MatchPolicy>* book(int v) { return venues[v].book.get(); }
+
+    void onQuote(int v, const TopOfBook& top) {
+        venues[v].quote = top;
+        ++quoteUpdates;
+        recomputeBbo();
+    }
+
+    // Re-reads an in-process venue's top of book after flow that bypassed the router.
+    void refreshQuote(int v) {
+        if (venues[v].book) onQuote(v, venues[v].book->topOfBook());
+    }
+
+    const ConsolidatedBbo& consolidated() const { return bbo; }
+    long quoteUpdateCount() const { return quoteUpdates; }
+
+    // Splits `quantity` across venues: levels are ranked by latency-adjusted price, then
+    // by latency, and taken greedily up to the limit. One child per venue, at the worst
+    // price it needs there, ordered by arrival time.
+    std::vector<ChildOrder> plan(Side side, double limitPrice, int quantity, long nowNs) const {
+        struct Slice {
+            double rank;
+            long latency;
+            double price;
+            long qty;
+            int venue;
+        };
+        std::vector<Slice> slices;
+        for (int v = 0; v < static_cast<int>(venues.size()); ++v) {
+            long latency = venues[v].config.latencyNs;
+            double penalty = latencyPenaltyBpsPerUs * (latency / 1000.0) * 1e-4;
+            for (const LevelInfo& level : liquidity(venues[v], side)) {
+                if (!marketable(side, level.price, limitPrice)) break;
+                double rank = side == Side::BUY ? level.price * (1.0 + penalty) : -level.price * (1.0 - penalty);
+                slices.push_back({rank, latency, level.price, level.quantity, v});
+            }
+        }
+        std::sort(slices.begin(), slices.end(), [](const Slice& a, const Slice& b) {
+            return a.rank != b.rank ? a.rank < b.rank : a.latency < b.latency;
+        });
+
+        std::map<int, ChildOrder> perVenue;
+        int remaining = quantity;
+        for (const Slice& s : slices) {
+            if (remaining == 0) break;
+            int take = static_cast<int>(std::min<long>(remaining, s.qty));
+            auto [it, fresh] = perVenue.try_emplace(s.venue, ChildOrder{s.venue, s.price, 0,
+                                                    nowNs + venues[s.venue].config.latencyNs, 0, 0.0});
+            ChildOrder& child = it->second;
+            child.quantity += take;
+            if (!fresh) child.price = side == Side::BUY ? std::max(child.price, s.price) : std::min(child.price, s.price);
+            remaining -= take;
+        }
+
+        std::vector<ChildOrder> children;
+        for (auto& [v, child] : perVenue) children.push_back(child);
+        std::sort(children.begin(), children.end(), [](const ChildOrder& a, const ChildOrder& b) {
+            return a.arrivalNs < b.arrivalNs;
+        });
+        return children;
+    }
+
+    // Plans, then sends each child to its in-process venue in arrival order as an
+    // immediate-or-cancel limit. Children for external venues are returned unfilled.
+    RouteResult route(Side side, double limitPrice, int quantity, long nowNs) {
+        RouteResult result{plan(side, limitPrice, quantity, nowNs), 0, 0.0};
+        double notional = 0.0;
+        for (ChildOrder& child : result.children) {
+            OrderBook<MatchPolicy>* venueBook = venues[child.venue].book.get();
+            if (!venueBook) continue;
+
+            std::size_t firstTrade = venueBook->withTape([](TradeTape& tape) { return tape.size(); });
+            int id = nextChildId++;
+            venueBook->addOrder({
+                .id = id,
+                .symbol = symbol,
+                .side = side,
+                .type = OrderType::LIMIT,
+                .quantity = child.quantity,
+                .price = child.price
+            });
+            venueBook->matchOrders();
+            if (venueBook->restingQuantity(id) > 0) venueBook->cancelOrder(id);
+
+            // Size and price come from the child's own trades; other flow may hit the
+            // venue's book at the same time, so depth changes are not all ours.
+            venueBook->withTape([&](TradeTape& tape) {
+                for (std::size_t i = firstTrade; i < tape.size(); ++i) {
+                    TradeRow trade = tape.row(i);
+                    if (trade.buyOrderId != id && trade.sellOrderId != id) continue;
+                    child.filled += trade.quantity;
+                    child.notional += trade.quantity * tape.price(i);
+                }
+            });
+            result.filled += child.filled;
+            notional += child.notional;
+            refreshQuote(child.venue);
+        }
+        result.avgPrice = result.filled > 0 ? notional / result.filled : 0.0;
+        return result;
+    }
+};
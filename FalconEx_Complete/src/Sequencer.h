@@ -0,0 +1,270 @@
+#pragma once
+// Deterministic sequencing for the book. Every input (add, cancel, modify, auction
+// open, uncross) is stamped with one global sequence number and applied in that order,
+// and every output event (each trade, plus each input's result) is folded into a
+// rolling hash. A book's output is then a pure function of its input sequence: the
+// journal of sequenced inputs replays to the same hash on a fresh book, and two book
+// implementations fed the same sequence can be compared event by event.
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "OrderBook.h"
+
+enum class InputType : std::uint8_t { ADD, CANCEL, MODIFY, AUCTION, UNCROSS };
+
+struct SequencedInput {
+    std::uint64_t seq;
+    InputType type;
+    Order order;      // ADD: id, timestamp and everything else already assigned
+    int orderId;      // CANCEL / MODIFY
+    double newPrice;  // MODIFY
+    int newQty;       // MODIFY
+};
+
+// FNV-1a over the binary fields of each event, chained: the value after event n covers
+// events 1..n, so equal values mean equal output streams up to that point.
+class OutputHash {
+private:
+    std::uint64_t h = 1469598103934665603ULL;
+    std::uint64_t events = 0;
+
+    void mix(std::uint64_t v) {
+        for (int i = 0; i < 8; ++i) {
+            h ^= (v >> (8 * i)) & 0xff;
+            h *= 1099511628211ULL;
+        }
+    }
+
+public:
+    // The trade timestamp is left out: it echoes the aggressor's input timestamp, and
+    // runs that differ only in wall-clock arrival times should hash equal.
+    void trade(const TradeRow& t) {
+        mix(1);
+        mix(static_cast<std::uint64_t>(t.priceTicks));
+        mix(static_cast<std::uint64_t>(t.quantity));
+        mix(static_cast<std::uint64_t>(t.aggressor));
+        mix(static_cast<std::uint64_t>(t.buyOrderId));
+        mix(static_cast<std::uint64_t>(t.sellOrderId));
+        ++events;
+    }
+
+    void result(std::uint64_t seq, long value) {
+        mix(2);
+        mix(seq);
+        mix(static_cast<std::uint64_t>(value));
+        ++events;
+    }
+
+    std::uint64_t value() const { return h; }
+    std::uint64_t count() const { return events; }
+};
+
+// What one input did: its result (ADD: quantity left resting; CANCEL/MODIFY: 1 if it
+// succeeded; UNCROSS: volume) and the trades it caused, in tape order.
+struct StepOutput {
+    long result;
+    std::vector<TradeRow> trades;
+    UncrossResult auction;  // UNCROSS only
+};
+
+// Applies sequenced inputs to one book and hashes what comes out. Trades are read back
+// from the book's tape, so the book needs no hooks for this. Any book with OrderBook's
+// public interface works.
+template <typename Book>
+class SequencedBook {
+private:
+    Book& book;
+    OutputHash hash;
+    std::size_t tradesSeen;
+    std::uint64_t lastSeq = 0;
+
+public:
+    explicit SequencedBook(Book& b)
+        : book(b), tradesSeen(b.withTape([](TradeTape& tape) { return tape.size(); })) {}
+
+    // Returns false, without applying, for an input out of sequence.
+    bool apply(const SequencedInput& in, StepOutput* out = nullptr) {
+        if (in.seq != lastSeq + 1) return false;
+        lastSeq = in.seq;
+
+        long result = 0;
+        UncrossResult auction{0.0, 0, 0};
+        switch (in.type) {
+            case InputType::ADD:
+                book.addOrder(in.order);
+                book.matchOrders();
+                result = book.restingQuantity(in.order.id);
+                break;
+            case InputType::CANCEL:
+                result = book.cancelOrder(in.orderId);
+                break;
+            case InputType::MODIFY:
+                result = book.modifyOrder(in.orderId, in.newPrice, in.newQty);
+                book.matchOrders();
+                break;
+            case InputType::AUCTION:
+                book.beginAuction();
+                break;
+            case InputType::UNCROSS:
+                auction = book.uncross();
+                result = auction.volume;
+                break;
+        }
+
+        if (out) {
+            out->result = result;
+            out->trades.clear();
+            out->auction = auction;
+        }
+        book.withTape([&](TradeTape& tape) {
+            for (; tradesSeen < tape.size(); ++tradesSeen) {
+                TradeRow row = tape.row(tradesSeen);
+                hash.trade(row);
+                if (out) out->trades.push_back(row);
+            }
+            return 0;
+        });
+        hash.result(in.seq, result);
+        return true;
+    }
+
+    std::uint64_t lastSequence() const { return lastSeq; }
+    const OutputHash& outputHash() const { return hash; }
+};
+
+// Stamps inputs from any number of threads with the next sequence number, applies them
+// to the book in exactly that order and journals them. Admission (throttling, load
+// shedding) happens before this point, so rejected orders never get a sequence number.
+template <typename Book>
+class Sequencer {
+private:
+    std::mutex seqMutex;
+    SequencedBook<Book> target;
+    std::vector<SequencedInput> journal;
+
+public:
+    explicit Sequencer(Book& book) : target(book) {}
+
+    StepOutput submit(SequencedInput in) {
+        std::lock_guard<std::mutex> lock(seqMutex);
+        in.seq = target.lastSequence() + 1;
+        StepOutput out;
+        target.apply(in, &out);
+        journal.push_back(std::move(in));
+        return out;
+    }
+
+    std::uint64_t sequenced() {
+        std::lock_guard<std::mutex> lock(seqMutex);
+        return target.lastSequence();
+    }
+
+    std::uint64_t outputHash() {
+        std::lock_guard<std::mutex> lock(seqMutex);
+        return target.outputHash().value();
+    }
+
+    std::vector<SequencedInput> journalCopy() {
+        std::lock_guard<std::mutex> lock(seqMutex);
+        return journal;
+    }
+};
+
+// One input per line: seq type, then the type's fields. Symbols must not contain spaces.
+inline bool writeJournal(const std::string& path, const std::vector<SequencedInput>& inputs) {
+    std::ofstream file(path);
+    if (!file) return false;
+    file << std::setprecision(17);
+    for (const SequencedInput& in : inputs) {
+        file << in.seq << " " << static_cast<int>(in.type);
+        if (in.type == InputType::ADD) {
+            const Order& o = in.order;
+            file << " " << o.id << " " << o.symbol << " " << static_cast<int>(o.side) << " "
+                 << static_cast<int>(o.type) << " " << o.quantity << " " << o.price << " " << o.timestamp
+                 << " " << o.clientId << " " << o.stopPrice;
+        } else if (in.type == InputType::CANCEL) {
+            file << " " << in.orderId;
+        } else if (in.type == InputType::MODIFY) {
+            file << " " << in.orderId << " " << in.newPrice << " " << in.newQty;
+        }
+        file << "\n";
+    }
+    return static_cast<bool>(file);
+}
+
+inline bool readJournal(const std::string& path, std::vector<SequencedInput>& inputs) {
+    std::ifstream file(path);
+    if (!file) return false;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty()) continue;
+        std::istringstream ss(line);
+        SequencedInput in{};
+        int type = 0;
+        ss >> in.seq >> type;
+        in.type = static_cast<InputType>(type);
+        if (in.type == InputType::ADD) {
+            Order& o = in.order;
+            int side = 0, orderType = 0;
+            ss >> o.id >> o.symbol >> side >> orderType >> o.quantity >> o.price >> o.timestamp >> o.clientId
+               >> o.stopPrice;
+            o.side = static_cast<Side>(side);
+            o.type = static_cast<OrderType>(orderType);
+        } else if (in.type == InputType::CANCEL) {
+            ss >> in.orderId;
+        } else if (in.type == InputType::MODIFY) {
+            ss >> in.orderId >> in.newPrice >> in.newQty;
+        }
+        if (!ss) return false;
+        inputs.push_back(std::move(in));
+    }
+    return true;
+}
+
+struct Divergence {
+    bool found;
+    std::uint64_t seq;          // first input whose output differs
+    StepOutput reference;
+    StepOutput candidate;
+    std::uint64_t outputEvents; // events both books agreed on before it
+};
+
+// Feeds the same inputs to a reference book and a candidate book, one at a time, and
+// stops at the first input where their outputs differ (result, trades, or top of book).
+template <typename Reference, typename Candidate>
+Divergence findDivergence(Reference& reference, Candidate& candidate, const std::vector<SequencedInput>& inputs,
+                          std::uint64_t* finalHash = nullptr) {
+    SequencedBook<Reference> ref(reference);
+    SequencedBook<Candidate> cand(candidate);
+    StepOutput a, b;
+    auto sameTrades = [](const std::vector<TradeRow>& x, const std::vector<TradeRow>& y) {
+        if (x.size() != y.size()) return false;
+        for (std::size_t i = 0; i < x.size(); ++i) {
+            if (x[i].timestamp != y[i].timestamp || x[i].priceTicks != y[i].priceTicks ||
+                x[i].quantity != y[i].quantity || x[i].aggressor != y[i].aggressor ||
+                x[i].buyOrderId != y[i].buyOrderId || x[i].sellOrderId != y[i].sellOrderId) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    for (const SequencedInput& in : inputs) {
+        std::uint64_t agreed = ref.outputHash().count();
+        ref.apply(in, &a);
+        cand.apply(in, &b);
+        TopOfBook ta = reference.topOfBook();
+        TopOfBook tb = candidate.topOfBook();
+        bool sameTop = ta.bidPrice == tb.bidPrice && ta.bidQty == tb.bidQty && ta.askPrice == tb.askPrice &&
+                       ta.askQty == tb.askQty;
+        if (a.result != b.result || !sameTrades(a.trades, b.trades) || !sameTop) {
+            return {true, in.seq, a, b, agreed};
+        }
+    }
+    if (finalHash) *finalHash = ref.outputHash().value();
+    return {false, 0, {}, {}, ref.outputHash().count()};
+}
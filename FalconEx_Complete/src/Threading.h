@@ -0,0 +1,139 @@
+#pragma once
+// Thread placement and waiting. pinThisThread() binds the calling thread to one CPU so
+// the scheduler cannot migrate it (and its warm caches) between cores; WaitMode says
+// how a thread waits for the book lock or for work: park in the kernel at once, spin
+// a bounded while and then park, or spin forever. Spinning only pays when the waiter
+// has a core to itself, so pair BUSY_POLL with pinning to an isolated CPU.
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+enum class WaitMode { BLOCK, SPIN_THEN_PARK, BUSY_POLL };
+
+// Spins before a SPIN_THEN_PARK waiter gives up and parks: roughly 1-10 us, depending
+// on how long the core's pause instruction takes.
+constexpr int kSpinBeforePark = 256;
+
+inline const char* waitModeName(WaitMode mode) {
+    switch (mode) {
+        case WaitMode::BLOCK: return "block";
+        case WaitMode::SPIN_THEN_PARK: return "spin";
+        case WaitMode::BUSY_POLL: return "busy";
+    }
+    return "block";
+}
+
+inline bool parseWaitMode(const std::string& name, WaitMode& mode) {
+    if (name == "block") mode = WaitMode::BLOCK;
+    else if (name == "spin") mode = WaitMode::SPIN_THEN_PARK;
+    else if (name == "busy") mode = WaitMode::BUSY_POLL;
+    else return false;
+    return true;
+}
+
+// One iteration of a spin loop: tells the core we are spinning (frees pipeline
+// resources for a hyperthread sibling, avoids the memory-order flush on exit).
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Returns false where affinity is unsupported or the CPU is not in our cpuset.
+inline bool pinThisThread(int cpu) {
+#ifdef __linux__
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+// "2,4-6" -> {2, 4, 5, 6}. Malformed items are skipped.
+inline std::vector<int> parseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        char* end = nullptr;
+        long first = std::strtol(item.c_str(), &end, 10);
+        if (end == item.c_str() || first < 0) continue;
+        long last = first;
+        if (*end == '-') {
+            const char* from = end + 1;
+            last = std::strtol(from, &end, 10);
+            if (end == from || last < first) continue;
+        }
+        if (*end != '\0') continue;
+        for (long cpu = first; cpu <= last; ++cpu) cpus.push_back(static_cast<int>(cpu));
+    }
+    return cpus;
+}
+
+// The i-th thread of a group takes the i-th CPU of its list, wrapping around; an empty
+// list leaves threads unpinned (-1).
+inline int cpuFor(const std::vector<int>& cpus, std::size_t i) {
+    return cpus.empty() ? -1 : cpus[i % cpus.size()];
+}
+
+// Acquires `lock` (deferred, not yet owned) according to `mode`. Returns true when the
+// first attempt failed, i.e. the lock was contended.
+template <typename Lock>
+bool acquire(Lock& lock, WaitMode mode) {
+    if (lock.try_lock()) return false;
+    if (mode == WaitMode::BLOCK) {
+        lock.lock();
+        return true;
+    }
+    for (int spins = 0; mode == WaitMode::BUSY_POLL || spins < kSpinBeforePark; ++spins) {
+        cpuRelax();
+        if (lock.try_lock()) return true;
+    }
+    lock.lock();
+    return true;
+}
+
+// Idle backoff for a thread polling for work: BUSY_POLL never leaves the CPU,
+// SPIN_THEN_PARK spins, then yields, then sleeps; BLOCK sleeps as soon as it is idle.
+class IdleWait {
+private:
+    WaitMode mode;
+    int idle = 0;
+
+public:
+    explicit IdleWait(WaitMode m) : mode(m) {}
+
+    void reset() { idle = 0; }
+
+    void wait() {
+        if (idle < kSpinBeforePark + 100) ++idle;
+        if (mode == WaitMode::BUSY_POLL) {
+            cpuRelax();
+        } else if (mode == WaitMode::SPIN_THEN_PARK && idle < kSpinBeforePark) {
+            cpuRelax();
+        } else if (mode == WaitMode::SPIN_THEN_PARK && idle < kSpinBeforePark + 100) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+};
@@ -0,0 +1,253 @@
+#pragma once
+// Order-path tracing. Each thread records TscClock-stamped spans (lock wait, addOrder,
+// matchOrders, ...) into its own fixed-size ring, and Tracer::dumpChromeTrace() writes
+// every ring out as Chrome trace JSON for chrome://tracing or ui.perfetto.dev.
+//
+// The FALCONEX_TRACE_* macros compile to nothing unless FALCONEX_TRACE is 1
+// (CMake: -DFALCONEX_TRACE=ON). When enabled, one operation in FALCONEX_TRACE_SAMPLE_EVERY
+// is traced: the outermost span decides, and every span nested in it follows, so a
+// sampled order keeps its whole path. A recorded span costs two TSC reads and one
+// 32-byte store into a thread-local buffer: no locks, no allocation; an unsampled one
+// a counter check. Work inside the matching loop is not given spans of its own: it
+// bumps per-thread counters (levels swept, trades), and each span carries how much
+// they moved while it was open.
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Clock.h"
+
+#ifndef FALCONEX_TRACE
+#define FALCONEX_TRACE 0
+#endif
+
+// Events kept per thread; older events are overwritten. Must be a power of two.
+#ifndef FALCONEX_TRACE_RING_EVENTS
+#define FALCONEX_TRACE_RING_EVENTS (1 << 15)
+#endif
+
+// One outermost span in this many is recorded, with everything nested in it. Must be a
+// power of two; 1 traces every operation.
+#ifndef FALCONEX_TRACE_SAMPLE_EVERY
+#define FALCONEX_TRACE_SAMPLE_EVERY 64
+#endif
+
+enum class TraceStage : std::uint8_t {
+    PLACE_ORDER,
+    LOCK_WAIT,
+    ADD_ORDER,
+    MATCH_ORDERS
+};
+
+inline const char* traceStageName(TraceStage stage) {
+    switch (stage) {
+        case TraceStage::PLACE_ORDER: return "placeOrder";
+        case TraceStage::LOCK_WAIT: return "lockWait";
+        case TraceStage::ADD_ORDER: return "addOrder";
+        case TraceStage::MATCH_ORDERS: return "matchOrders";
+    }
+    return "unknown";
+}
+
+// Per-thread running totals of work done inside spans.
+struct TraceCounts {
+    std::uint32_t levels = 0;  // price levels swept by an aggressor
+    std::uint32_t trades = 0;
+};
+
+struct TraceEvent {
+    std::uint64_t start;  // TSC ticks
+    std::uint64_t end;
+    int orderId;
+    std::uint32_t levels;  // counts during the span
+    std::uint32_t trades;
+    TraceStage stage;
+};
+
+// Single-writer ring owned by one thread. Readers only look at it from dump, which
+// is meant to run while the traced threads are quiet.
+class TraceRing {
+private:
+    static constexpr std::uint64_t kMask = FALCONEX_TRACE_RING_EVENTS - 1;
+    static_assert((FALCONEX_TRACE_RING_EVENTS & kMask) == 0, "FALCONEX_TRACE_RING_EVENTS must be a power of two");
+
+    std::vector<TraceEvent> events;
+    std::atomic<std::uint64_t> written{0};
+
+public:
+    const int tid;
+
+    explicit TraceRing(int threadIndex) : events(FALCONEX_TRACE_RING_EVENTS), tid(threadIndex) {}
+
+    void push(const TraceEvent& e) {
+        std::uint64_t n = written.load(std::memory_order_relaxed);
+        events[n & kMask] = e;
+        written.store(n + 1, std::memory_order_release);
+    }
+
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        std::uint64_t n = written.load(std::memory_order_acquire);
+        std::uint64_t first = n > events.size() ? n - events.size() : 0;
+        for (std::uint64_t i = first; i < n; ++i) fn(events[i & kMask]);
+    }
+};
+
+class Tracer {
+private:
+    static constexpr std::uint32_t kSampleMask = FALCONEX_TRACE_SAMPLE_EVERY - 1;
+    static_assert((FALCONEX_TRACE_SAMPLE_EVERY & kSampleMask) == 0, "FALCONEX_TRACE_SAMPLE_EVERY must be a power of two");
+
+    // Everything a thread's tracepoints touch, behind one thread_local lookup.
+    struct ThreadState {
+        TraceCounts counts;
+        int orderId = 0;
+        int depth = 0;         // spans open
+        bool sampled = false;  // whether the open spans are being recorded
+        std::uint32_t roots = 0;
+    };
+
+    static ThreadState& state() {
+        thread_local ThreadState s;
+        return s;
+    }
+
+    struct Registry {
+        std::mutex registryMutex;
+        std::vector<std::unique_ptr<TraceRing>> rings;
+    };
+
+    static Registry& registry() {
+        static Registry r;
+        return r;
+    }
+
+    static TraceRing& ring() {
+        thread_local TraceRing* mine = [] {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.registryMutex);
+            r.rings.push_back(std::make_unique<TraceRing>(static_cast<int>(r.rings.size()) + 1));
+            return r.rings.back().get();
+        }();
+        return *mine;
+    }
+
+public:
+    static std::uint64_t now() { return TscClock::ticks(); }
+
+    // Order id attached to every span this thread records until reset.
+    static int& currentOrder() { return state().orderId; }
+
+    static TraceCounts& counts() { return state().counts; }
+
+    // A span opens; returns whether it is recorded. The outermost span takes the sampling
+    // decision for everything nested in it.
+    static bool enter() {
+        ThreadState& s = state();
+        if (s.depth++ == 0) s.sampled = (s.roots++ & kSampleMask) == 0;
+        return s.sampled;
+    }
+
+    static void leave() { --state().depth; }
+
+    // Whether an explicit start/stop pair inside the current span should be timed.
+    static bool sampling() {
+        const ThreadState& s = state();
+        return s.depth > 0 && s.sampled;
+    }
+
+    static void record(TraceStage stage, std::uint64_t start, TraceCounts at = counts()) {
+        std::uint64_t end = now();
+        const TraceCounts& c = counts();
+        ring().push({start, end, currentOrder(), c.levels - at.levels, c.trades - at.trades, stage});
+    }
+
+    // Returns the number of events written.
+    static long dumpChromeTrace(const std::string& path) {
+        Registry& r = registry();
+        double perUs = 1000.0 / TscClock::nsPerTick();
+        std::lock_guard<std::mutex> lock(r.registryMutex);
+
+        std::uint64_t origin = UINT64_MAX;
+        for (const auto& ring : r.rings) {
+            ring->forEach([&](const TraceEvent& e) { origin = std::min(origin, e.start); });
+        }
+
+        std::ofstream out(path);
+        out << std::fixed << std::setprecision(3);
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+        long count = 0;
+        for (const auto& ring : r.rings) {
+            ring->forEach([&](const TraceEvent& e) {
+                out << (count++ ? ",\n" : "")
+                    << "{\"name\":\"" << traceStageName(e.stage) << "\",\"cat\":\"order\",\"ph\":\"X\""
+                    << ",\"ts\":" << (e.start - origin) / perUs
+                    << ",\"dur\":" << (e.end - e.start) / perUs
+                    << ",\"pid\":1,\"tid\":" << ring->tid
+                    << ",\"args\":{\"order\":" << e.orderId << ",\"levels\":" << e.levels
+                    << ",\"trades\":" << e.trades << "}}";
+            });
+        }
+        out << "\n]}\n";
+        return count;
+    }
+};
+
+class TraceSpan {
+private:
+    TraceStage stage;
+    bool recorded;
+    TraceCounts at;
+    std::uint64_t start = 0;
+
+public:
+    explicit TraceSpan(TraceStage s) : stage(s), recorded(Tracer::enter()) {
+        if (recorded) {
+            at = Tracer::counts();
+            start = Tracer::now();
+        }
+    }
+    ~TraceSpan() {
+        if (recorded) Tracer::record(stage, start, at);
+        Tracer::leave();
+    }
+};
+
+class TraceOrderScope {
+private:
+    int previous;
+
+public:
+    explicit TraceOrderScope(int orderId) : previous(Tracer::currentOrder()) { Tracer::currentOrder() = orderId; }
+    ~TraceOrderScope() { Tracer::currentOrder() = previous; }
+};
+
+#define FALCONEX_TRACE_CAT_(a, b) a##b
+#define FALCONEX_TRACE_CAT(a, b) FALCONEX_TRACE_CAT_(a, b)
+
+#if FALCONEX_TRACE
+// Span covering the rest of the enclosing scope.
+#define FALCONEX_TRACE_SCOPE(stage) TraceSpan FALCONEX_TRACE_CAT(traceSpan_, __LINE__)(TraceStage::stage)
+// Tags spans recorded by this thread in the enclosing scope with an order id.
+#define FALCONEX_TRACE_ORDER(id) TraceOrderScope FALCONEX_TRACE_CAT(traceOrder_, __LINE__)(id)
+// Explicit start/stop for spans that do not end at a scope boundary (e.g. lock waits).
+// Only recorded inside a sampled FALCONEX_TRACE_SCOPE.
+#define FALCONEX_TRACE_START(name) const std::uint64_t name = Tracer::sampling() ? Tracer::now() : 0
+#define FALCONEX_TRACE_STOP(stage, name) \
+    do { \
+        if (name) Tracer::record(TraceStage::stage, name); \
+    } while (0)
+// Bumps a TraceCounts field; the enclosing spans report the total as an argument.
+#define FALCONEX_TRACE_COUNT(field) (++Tracer::counts().field)
+#else
+#define FALCONEX_TRACE_SCOPE(stage) ((void)0)
+#define FALCONEX_TRACE_ORDER(id) ((void)0)
+#define FALCONEX_TRACE_START(name) ((void)0)
+#define FALCONEX_TRACE_STOP(stage, name) ((void)0)
+#define FALCONEX_TRACE_COUNT(field) ((void)0)
+#endif
@@ -0,0 +1,264 @@
+#pragma once
+// Columnar trade tape with incremental bars and rolling windows. Trades are appended
+// into fixed-size chunks, one array per column, so appends never move existing rows
+// and scans touch only the columns they need. Inclusive prefix sums of quantity and
+// notional are stored alongside, which makes volume/VWAP over any row range O(1).
+//
+// Time bars and volume bars (OHLCV + VWAP) are extended on every append. Rolling time
+// windows keep a moving start row and monotonic max/min queues, so their OHLCV/VWAP
+// is also O(1) to read (amortized O(1) to maintain).
+//
+// Prices are stored as integer ticks. Not synchronized; OrderBook guards its tape
+// with bookMutex (see OrderBook::withTape).
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+enum class TradeAggressor : std::uint8_t { BUY, SELL, AUCTION };
+
+struct TradeRow {
+    long timestamp;
+    std::int64_t priceTicks;
+    int quantity;
+    TradeAggressor aggressor;
+    int buyOrderId;
+    int sellOrderId;
+};
+
+struct VolumeStats {
+    long trades;
+    long volume;
+    double vwap;  // 0 when volume is 0
+};
+
+struct WindowStats {
+    long trades;
+    long volume;
+    double vwap;
+    double open;
+    double high;
+    double low;
+    double close;
+};
+
+struct Bar {
+    long start;  // time bars: interval start; volume bars: first trade's timestamp
+    std::int64_t open;
+    std::int64_t high;
+    std::int64_t low;
+    std::int64_t close;
+    long volume;
+    std::int64_t notional;  // sum of priceTicks * quantity
+    long trades;
+};
+
+// Bars of a fixed time interval or a fixed traded quantity. Volume bars split a trade
+// that straddles the boundary, so every closed volume bar holds exactly `size` shares.
+// Time bars are only created for intervals that saw a trade.
+class BarBuilder {
+private:
+    bool byVolume = false;
+    long size = 0;  // 0 disables
+    std::vector<Bar> bars;
+    // Prefix sums over closed bars, for O(1) aggregates of the last n bars.
+    std::vector<long> cumVolume{0};
+    std::vector<std::int64_t> cumNotional{0};
+    std::vector<long> cumTrades{0};
+
+    void open(long ts, std::int64_t ticks) {
+        long start = byVolume ? ts : ts - ((ts % size) + size) % size;
+        bars.push_back({start, ticks, ticks, ticks, ticks, 0, 0, 0});
+    }
+
+    void close() {
+        const Bar& b = bars.back();
+        cumVolume.push_back(cumVolume.back() + b.volume);
+        cumNotional.push_back(cumNotional.back() + b.notional);
+        cumTrades.push_back(cumTrades.back() + b.trades);
+    }
+
+    void extend(std::int64_t ticks, long qty, long trades) {
+        Bar& b = bars.back();
+        b.high = std::max(b.high, ticks);
+        b.low = std::min(b.low, ticks);
+        b.close = ticks;
+        b.volume += qty;
+        b.notional += ticks * qty;
+        b.trades += trades;
+    }
+
+public:
+    void configure(bool volumeBars, long barSize) {
+        byVolume = volumeBars;
+        size = barSize;
+        bars.clear();
+        cumVolume.assign(1, 0);
+        cumNotional.assign(1, 0);
+        cumTrades.assign(1, 0);
+    }
+
+    bool enabled() const { return size > 0; }
+
+    void add(long ts, std::int64_t ticks, int qty) {
+        if (size <= 0) return;
+        if (!byVolume) {
+            if (bars.empty() || ts >= bars.back().start + size) {
+                if (!bars.empty()) close();
+                open(ts, ticks);
+            }
+            extend(ticks, qty, 1);
+            return;
+        }
+        long left = qty;
+        long trades = 1;
+        while (left > 0) {
+            if (bars.empty() || bars.back().volume == size) {
+                if (!bars.empty()) close();
+                open(ts, ticks);
+            }
+            long take = std::min(left, size - bars.back().volume);
+            extend(ticks, take, trades);
+            trades = 0;  // a split trade counts once, in the bar where it starts
+            left -= take;
+        }
+    }
+
+    // All bars, the last one still open.
+    const std::vector<Bar>& all() const { return bars; }
+
+    // Volume/VWAP over the last n bars including the open one, in O(1).
+    VolumeStats last(std::size_t n, double tickSize) const {
+        if (bars.empty() || n == 0) return {0, 0, 0.0};
+        std::size_t closed = bars.size() - 1;
+        std::size_t fromClosed = std::min(n - 1, closed);
+        const Bar& cur = bars.back();
+        long volume = cur.volume + cumVolume[closed] - cumVolume[closed - fromClosed];
+        std::int64_t notional = cur.notional + cumNotional[closed] - cumNotional[closed - fromClosed];
+        long trades = cur.trades + cumTrades[closed] - cumTrades[closed - fromClosed];
+        return {trades, volume, volume > 0 ? notional * tickSize / volume : 0.0};
+    }
+};
+
+class TradeTape {
+private:
+    static constexpr std::size_t kChunkRows = 4096;
+
+    struct Chunk {
+        long timestamp[kChunkRows];
+        std::int64_t priceTicks[kChunkRows];
+        int quantity[kChunkRows];
+        TradeAggressor aggressor[kChunkRows];
+        int buyOrderId[kChunkRows];
+        int sellOrderId[kChunkRows];
+        std::int64_t cumQty[kChunkRows];       // inclusive prefix sums
+        std::int64_t cumNotional[kChunkRows];
+    };
+
+    struct RollingWindow {
+        long durationNs;
+        std::size_t start = 0;  // first row inside the window
+        std::deque<std::size_t> maxRows;  // prices decreasing
+        std::deque<std::size_t> minRows;  // prices increasing
+    };
+
+    double tickSize;
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    std::size_t rows = 0;
+    BarBuilder timeBarBuilder;
+    BarBuilder volumeBarBuilder;
+    std::vector<RollingWindow> windows;
+
+    const Chunk& chunk(std::size_t i) const { return *chunks[i / kChunkRows]; }
+
+    std::int64_t cumQtyBefore(std::size_t i) const { return i == 0 ? 0 : chunk(i - 1).cumQty[(i - 1) % kChunkRows]; }
+    std::int64_t cumNotionalBefore(std::size_t i) const {
+        return i == 0 ? 0 : chunk(i - 1).cumNotional[(i - 1) % kChunkRows];
+    }
+
+    void advance(RollingWindow& w, std::size_t row, long ts) {
+        std::int64_t ticks = priceTicks(row);
+        while (!w.maxRows.empty() && priceTicks(w.maxRows.back()) <= ticks) w.maxRows.pop_back();
+        w.maxRows.push_back(row);
+        while (!w.minRows.empty() && priceTicks(w.minRows.back()) >= ticks) w.minRows.pop_back();
+        w.minRows.push_back(row);
+
+        while (timestamp(w.start) <= ts - w.durationNs) ++w.start;
+        while (w.maxRows.front() < w.start) w.maxRows.pop_front();
+        while (w.minRows.front() < w.start) w.minRows.pop_front();
+    }
+
+public:
+    explicit TradeTape(double tick = 0.01, long timeBarNs = 1000000000L, long volumeBarQty = 1000) : tickSize(tick) {
+        timeBarBuilder.configure(false, timeBarNs);
+        volumeBarBuilder.configure(true, volumeBarQty);
+    }
+
+    void append(long ts, double price, int qty, TradeAggressor aggressor, int buyOrderId, int sellOrderId) {
+        if (rows % kChunkRows == 0) chunks.push_back(std::make_unique<Chunk>());
+        Chunk& c = *chunks.back();
+        std::size_t slot = rows % kChunkRows;
+        std::int64_t ticks = std::llround(price / tickSize);
+        c.timestamp[slot] = ts;
+        c.priceTicks[slot] = ticks;
+        c.quantity[slot] = qty;
+        c.aggressor[slot] = aggressor;
+        c.buyOrderId[slot] = buyOrderId;
+        c.sellOrderId[slot] = sellOrderId;
+        c.cumQty[slot] = cumQtyBefore(rows) + qty;
+        c.cumNotional[slot] = cumNotionalBefore(rows) + ticks * qty;
+        std::size_t row = rows++;
+
+        timeBarBuilder.add(ts, ticks, qty);
+        volumeBarBuilder.add(ts, ticks, qty);
+        for (RollingWindow& w : windows) advance(w, row, ts);
+    }
+
+    std::size_t size() const { return rows; }
+    double tick() const { return tickSize; }
+
+    long timestamp(std::size_t i) const { return chunk(i).timestamp[i % kChunkRows]; }
+    std::int64_t priceTicks(std::size_t i) const { return chunk(i).priceTicks[i % kChunkRows]; }
+    double price(std::size_t i) const { return priceTicks(i) * tickSize; }
+
+    TradeRow row(std::size_t i) const {
+        const Chunk& c = chunk(i);
+        std::size_t slot = i % kChunkRows;
+        return {c.timestamp[slot], c.priceTicks[slot], c.quantity[slot], c.aggressor[slot],
+                c.buyOrderId[slot], c.sellOrderId[slot]};
+    }
+
+    // Volume/VWAP over rows [from, to), in O(1).
+    VolumeStats range(std::size_t from, std::size_t to) const {
+        if (to <= from) return {0, 0, 0.0};
+        long volume = static_cast<long>(cumQtyBefore(to) - cumQtyBefore(from));
+        std::int64_t notional = cumNotionalBefore(to) - cumNotionalBefore(from);
+        return {static_cast<long>(to - from), volume, volume > 0 ? notional * tickSize / volume : 0.0};
+    }
+
+    VolumeStats lastTrades(std::size_t n) const { return range(rows - std::min(n, rows), rows); }
+
+    // Reconfiguring drops the bars built so far.
+    void setTimeBars(long intervalNs) { timeBarBuilder.configure(false, intervalNs); }
+    void setVolumeBars(long quantity) { volumeBarBuilder.configure(true, quantity); }
+    const BarBuilder& timeBars() const { return timeBarBuilder; }
+    const BarBuilder& volumeBars() const { return volumeBarBuilder; }
+
+    // A window covering the trades of the last durationNs, measured back from the most
+    // recent trade. Windows only see trades appended after they are added.
+    std::size_t addRollingWindow(long durationNs) {
+        windows.push_back({durationNs, rows, {}, {}});
+        return windows.size() - 1;
+    }
+
+    WindowStats window(std::size_t id) const {
+        const RollingWindow& w = windows[id];
+        if (w.start >= rows) return {0, 0, 0.0, 0.0, 0.0, 0.0, 0.0};
+        VolumeStats v = range(w.start, rows);
+        return {v.trades, v.volume, v.vwap, price(w.start), price(w.maxRows.front()),
+                price(w.minRows.front()), price(rows - 1)};
+    }
+};
@@ -5,147 +5,298 @@
 #include <thread>
 #include <mutex>
 #include <atomic>
+#include <memory>
 #include <chrono>
 #include <fstream>
 #include <iomanip>
 #include <random>
 #include <sstream>
+#include "Clock.h"
+#include "HugePages.h"
+#include "Ingress.h"
+#include "Metrics.h"
+#include "OrderBook.h"
+#include "ReplicaBook.h"
+#include "Router.h"
+#include "Sequencer.h"
+#include "Threading.h"
 
 using namespace std;
 using namespace std::chrono;
 
-enum class OrderType { LIMIT, MARKET };
-enum class Side { BUY, SELL };
+struct OrderAck {
+    IngressResult result;
+    int orderId;  // 0 when the order was turned away at ingress
+};
+
+struct SimConfig {
+    int agents = 10000;
+    int ordersPerAgent = 100;
+    long minLatencyNs = 20000;       // one-way agent-to-engine latency, drawn per agent
+    long maxLatencyNs = 500000;
+    long clientThinkNs = 1000000;    // mean gap between a client's orders (simulateClients sleeps 1 ms)
+    long momentumStepNs = 5000000;   // runMomentumStrategy sleeps 5 ms per step
+    int momentumEvery = 10;          // every Nth agent runs the momentum strategy
+    unsigned seed = 42;
+};
 
-struct Order {
-    int id;
-    string symbol;
+struct SimEvent {
+    long time;      // simulated ns since session start
+    long seq;       // scheduling order, breaks ties between equal times
+    int agent;
+    bool arrival;   // false: the agent wakes and decides; true: its order reaches the engine
     Side side;
-    OrderType type;
-    int quantity;
     double price;
-    long timestamp;
+    int quantity;
 };
 
-class OrderBook {
+// Simulated clock plus a min-heap of pending events. Popping an event advances the
+// clock to its time; equal times come out in the order they were scheduled, so a
+// session is a pure function of its inputs.
+class EventScheduler {
 private:
-    map<double, queue<Order>, greater<double>> buyOrders;
-    map<double, queue<Order>> sellOrders;
-    mutex bookMutex;
-    vector<string> tradeLog;
+    struct Later {
+        bool operator()(const SimEvent& a, const SimEvent& b) const {
+            return a.time != b.time ? a.time > b.time : a.seq > b.seq;
+        }
+    };
+
+    priority_queue<SimEvent, vector<SimEvent>, Later> pending;
+    long now = 0;
+    long nextSeq = 0;
 
 public:
-    void addOrder(const Order& order) {
-        lock_guard<mutex> lock(bookMutex);
+    void schedule(SimEvent e) {
+        e.seq = nextSeq++;
+        pending.push(e);
+    }
+
+    bool empty() const { return pending.empty(); }
+
+    SimEvent pop() {
+        SimEvent e = pending.top();
+        pending.pop();
+        now = e.time;
+        return e;
+    }
+
+    long clock() const { return now; }
+    long scheduled() const { return nextSeq; }
+};
+
+template <typename MatchPolicy = FifoMatch>
+class MatchingEngine {
+private:
+    OrderBook<MatchPolicy> book;
+    IngressGate gate;
+    atomic<int> orderIdCounter{1};
+    MetricsPage* metricsPage = nullptr;
+    BookFeed feed;
+    vector<unique_ptr<ReplicaBook>> replicas;  // declared after book/feed: stopped first
+    unique_ptr<Sequencer<OrderBook<MatchPolicy>>> sequencer;  // null unless sequenced
+    unsigned seed = 0;  // 0: sim and strat draw from random_device
+    WaitMode waitMode = WaitMode::BLOCK;
+    vector<int> gatewayCpus;  // sim client threads
+    vector<int> replicaCpus;
+    size_t momentumWindow = book.withTape([](TradeTape& tape) { return tape.addRollingWindow(1000000000L); });
+
+    OrderAck submit(Order o, long now) {
+        IngressResult admitted = gate.admit(o.clientId, now);
+        if (admitted != IngressResult::ACCEPTED) return {admitted, 0};
 
-        if (order.side == Side::BUY) {
-            buyOrders[order.price].push(order);
+        o.id = orderIdCounter++;
+        o.timestamp = now;
+        FALCONEX_TRACE_ORDER(o.id);
+        FALCONEX_TRACE_SCOPE(PLACE_ORDER);
+        if (sequencer) {
+            sequencer->submit({0, InputType::ADD, o, 0, 0.0, 0});
         } else {
-            sellOrders[order.price].push(order);
+            book.addOrder(o);
+            book.matchOrders();
         }
+        gate.release();
+        return {admitted, o.id};
     }
 
-    void matchOrders() {
-        lock_guard<mutex> lock(bookMutex);
+    unsigned drawSeed() {
+        return seed != 0 ? seed : random_device{}();
+    }
 
-        while (!buyOrders.empty() && !sellOrders.empty()) {
-            auto highestBuy = buyOrders.begin();
-            auto lowestSell = sellOrders.begin();
+    static void printAck(const OrderAck& ack) {
+        if (ack.result == IngressResult::ACCEPTED) {
+            cout << "Order ID: " << ack.orderId << endl;
+        } else {
+            cout << "Rejected: " << (ack.result == IngressResult::THROTTLED ? "throttled" : "shed") << endl;
+        }
+    }
 
-            if (highestBuy->first >= lowestSell->first) {
-                Order buyOrder = highestBuy->second.front();
-                Order sellOrder = lowestSell->second.front();
+public:
+    // Book nodes come from `memory` (see HugePages.h), which must outlive the engine.
+    explicit MatchingEngine(std::pmr::memory_resource* memory = std::pmr::get_default_resource()) : book(memory) {}
 
-                int tradedQty = min(buyOrder.quantity, sellOrder.quantity);
+    // How the book lock and the replica threads wait. Set before replicas or clients start.
+    void setWaitMode(WaitMode mode) {
+        waitMode = mode;
+        book.setWaitMode(mode);
+    }
 
-                stringstream log;
-                log << "TRADE: " << tradedQty << " shares of " << buyOrder.symbol
-                    << " at $" << fixed << setprecision(2) << lowestSell->first;
-                tradeLog.push_back(log.str());
-                cout << log.str() << endl;
+    // CPUs for sim client threads and replica threads; the i-th thread takes the i-th CPU,
+    // wrapping around. Empty lists leave threads unpinned.
+    void setThreadCpus(const vector<int>& gateways, const vector<int>& replicaList) {
+        gatewayCpus = gateways;
+        replicaCpus = replicaList;
+    }
 
-                buyOrder.quantity -= tradedQty;
-                sellOrder.quantity -= tradedQty;
+    OrderAck placeOrder(Side side, OrderType type, double price, int quantity,
+                        const string& symbol = "AAPL", int clientId = 0) {
+        return placeOrderAt(TscClock::nowNs(), side, type, price, quantity, symbol, clientId);
+    }
 
-                if (buyOrder.quantity == 0) {
-                    highestBuy->second.pop();
-                    if (highestBuy->second.empty()) buyOrders.erase(highestBuy);
-                } else {
-                    highestBuy->second.front().quantity = buyOrder.quantity;
-                }
+    // Same as placeOrder, stamped with a caller-supplied clock (e.g. simulated time).
+    OrderAck placeOrderAt(long now, Side side, OrderType type, double price, int quantity,
+                          const string& symbol = "AAPL", int clientId = 0) {
+        return submit({
+            .symbol = symbol,
+            .side = side,
+            .type = type,
+            .quantity = quantity,
+            .price = price,
+            .clientId = clientId
+        }, now);
+    }
 
-                if (sellOrder.quantity == 0) {
-                    lowestSell->second.pop();
-                    if (lowestSell->second.empty()) sellOrders.erase(lowestSell);
-                } else {
-                    lowestSell->second.front().quantity = sellOrder.quantity;
-                }
+    // A limitPrice of 0 makes a plain stop, which fires as a market order.
+    OrderAck placeStopOrder(Side side, double stopPrice, double limitPrice, int quantity,
+                            const string& symbol = "AAPL", int clientId = 0) {
+        return submit({
+            .symbol = symbol,
+            .side = side,
+            .type = limitPrice > 0.0 ? OrderType::STOP_LIMIT : OrderType::STOP,
+            .quantity = quantity,
+            .price = limitPrice,
+            .clientId = clientId,
+            .stopPrice = stopPrice
+        }, TscClock::nowNs());
+    }
 
-            } else {
-                break;
-            }
+    bool cancelOrder(int orderId) {
+        gate.admitCancel();
+        bool cancelled = sequencer ? sequencer->submit({0, InputType::CANCEL, {}, orderId, 0.0, 0}).result != 0
+                                   : book.cancelOrder(orderId);
+        gate.release();
+        return cancelled;
+    }
+
+    // From here on every book input takes a global sequence number and is journaled,
+    // and the book's output is hashed; a journal replays to the same hash (falconex_diff).
+    void enableSequencing() {
+        if (!sequencer) sequencer = make_unique<Sequencer<OrderBook<MatchPolicy>>>(book);
+    }
+
+    // Fixes the random streams of sim and strat; 0 goes back to random_device.
+    void setSeed(unsigned s) { seed = s; }
+
+    void printSequencing() {
+        if (!sequencer) {
+            cout << "Sequencing off (start with --sequenced)." << endl;
+            return;
         }
+        cout << "Sequenced inputs: " << sequencer->sequenced() << " | Output hash: " << hex
+             << sequencer->outputHash() << dec << endl;
     }
 
-    void printBook() {
-        lock_guard<mutex> lock(bookMutex);
-        cout << "\nOrder Book Snapshot:" << endl;
-        cout << "BUY SIDE:" << endl;
-        for (auto& [price, q] : buyOrders) {
-            cout << "Price: $" << price << " Qty: " << q.front().quantity << endl;
+    void writeJournalFile(const string& path) {
+        if (!sequencer) {
+            cout << "Sequencing off (start with --sequenced)." << endl;
+            return;
         }
-        cout << "SELL SIDE:" << endl;
-        for (auto& [price, q] : sellOrders) {
-            cout << "Price: $" << price << " Qty: " << q.front().quantity << endl;
+        vector<SequencedInput> journal = sequencer->journalCopy();
+        if (writeJournal(path, journal)) {
+            cout << "Wrote " << journal.size() << " sequenced inputs to " << path << endl;
+        } else {
+            cout << "Cannot write " << path << endl;
         }
     }
 
-    void exportLog(const string& filename) {
-        ofstream file(filename);
-        for (const auto& entry : tradeLog) {
-            file << entry << endl;
+    void configureThrottle(const ThrottleConfig& config) { gate.configure(config); }
+
+    void attachMetrics(MetricsPage* page) {
+        metricsPage = page;
+        gate.attachMetrics(page);
+        book.attachMetrics(page);
+    }
+
+    // Starts read-only replica books fed from the book's event stream. Call once,
+    // before any orders arrive; `show` and `replicas` are then served without bookMutex.
+    void startReplicas(int count) {
+        if (count <= 0 || !replicas.empty()) return;
+        for (int i = 0; i < count; ++i) feed.subscribe();
+        book.attachFeed(&feed);
+        for (int i = 0; i < count; ++i) {
+            replicas.push_back(make_unique<ReplicaBook>(feed, i, [this](size_t sub) { book.republish(sub); },
+                                                        metricsPage, waitMode, cpuFor(replicaCpus, i)));
+            replicas.back()->start();
         }
-        file.close();
     }
-};
 
-class MatchingEngine {
-private:
-    OrderBook book;
-    atomic<int> orderIdCounter{1};
+    void printReplicaStats() const {
+        if (replicas.empty()) {
+            cout << "No replicas running (start with --replicas N)." << endl;
+            return;
+        }
+        for (size_t i = 0; i < replicas.size(); ++i) {
+            ReplicaStats s = replicas[i]->stats();
+            TopOfBook top = replicas[i]->topOfBook();
+            stringstream line;
+            line << "Replica " << i << ": seq " << s.appliedSeq << " | lag " << s.lagEvents << " events / "
+                 << s.lagNs << " ns | resyncs " << s.resyncs << " | trades " << s.trades << " | volume "
+                 << s.volume << " | VWAP $" << fixed << setprecision(4) << s.vwap << " | BBO " << top.bidQty
+                 << " @ $" << setprecision(2) << top.bidPrice << " / " << top.askQty << " @ $" << top.askPrice;
+            cout << line.str() << endl;
+        }
+    }
 
-public:
-    void placeOrder(Side side, OrderType type, double price, int quantity, const string& symbol = "AAPL") {
-        Order o = {
-            .id = orderIdCounter++,
-            .symbol = symbol,
-            .side = side,
-            .type = type,
-            .quantity = quantity,
-            .price = price,
-            .timestamp = chrono::system_clock::now().time_since_epoch().count()
-        };
-        book.addOrder(o);
-        book.matchOrders();
+    void setTradeEcho(bool on) { book.setTradeEcho(on); }
+
+    void beginAuction() {
+        if (sequencer) sequencer->submit({0, InputType::AUCTION, {}, 0, 0.0, 0});
+        else book.beginAuction();
+    }
+
+    UncrossResult runUncross() {
+        uint64_t start = TscClock::ticks();
+        UncrossResult result = sequencer ? sequencer->submit({0, InputType::UNCROSS, {}, 0, 0.0, 0}).auction
+                                         : book.uncross();
+        long elapsed = TscClock::elapsedNs(start, TscClock::ticks()) / 1000;
+        if (result.volume == 0) {
+            cout << "Auction closed with no cross." << endl;
+        } else {
+            stringstream msg;
+            msg << "Uncrossed " << result.volume << " shares at $" << fixed << setprecision(2)
+                << result.price << " (imbalance " << result.imbalance << ") in " << elapsed << " us";
+            cout << msg.str() << endl;
+        }
+        return result;
     }
 
     void simulateClients(int numThreads, int numOrdersPerThread) {
         vector<thread> threads;
-        random_device rd;
-        mt19937 gen(rd());
+        mt19937 gen(drawSeed());
         uniform_real_distribution<> priceDist(100.0, 110.0);
         uniform_int_distribution<> qtyDist(1, 100);
         uniform_int_distribution<> sideDist(0, 1);
 
-        auto start = high_resolution_clock::now();
+        uint64_t start = TscClock::ticks();
 
         for (int i = 0; i < numThreads; ++i) {
-            threads.emplace_back([=]() mutable {
+            threads.emplace_back([=, this]() mutable {
+                int cpu = cpuFor(gatewayCpus, i);
+                if (cpu >= 0 && !pinThisThread(cpu)) cerr << "client " << i << ": cannot pin to CPU " << cpu << "\n";
                 for (int j = 0; j < numOrdersPerThread; ++j) {
                     Side side = sideDist(gen) == 0 ? Side::BUY : Side::SELL;
                     double price = priceDist(gen);
                     int qty = qtyDist(gen);
-                    placeOrder(side, OrderType::LIMIT, price, qty);
+                    placeOrder(side, OrderType::LIMIT, price, qty, "AAPL", i);
                     this_thread::sleep_for(chrono::milliseconds(1));
                 }
             });
@@ -155,17 +306,210 @@ public:
             t.join();
         }
 
-        auto end = high_resolution_clock::now();
-        auto duration = duration_cast<milliseconds>(end - start).count();
+        long duration = TscClock::elapsedNs(start, TscClock::ticks()) / 1000000;
         int totalOrders = numThreads * numOrdersPerThread;
 
         cout << "\n===== BENCHMARK RESULTS =====" << endl;
         cout << "Total Orders: " << totalOrders << endl;
         cout << "Total Time: " << duration << " ms" << endl;
         cout << "Throughput: " << (totalOrders * 1000.0 / duration) << " orders/sec" << endl;
+        gate.printStats();
+        cout << "=============================" << endl;
+    }
+
+    // Fills a private book with an ask ladder and thousands of buy stops, then times one
+    // sweep that triggers every stop and the cascade of market orders they re-enter as.
+    void benchmarkStopCascade(int numStops) {
+        OrderBook<MatchPolicy> bench;
+        bench.setTradeEcho(false);
+        int nextId = 1;
+        auto make = [&](Side side, OrderType type, double price, int qty, double stopPrice) {
+            return Order{
+                .id = nextId++,
+                .symbol = "AAPL",
+                .side = side,
+                .type = type,
+                .quantity = qty,
+                .price = price,
+                .stopPrice = stopPrice
+            };
+        };
+
+        int sweepLevels = max(1, numStops / 10);
+        for (int i = 0; i < 2 * numStops; ++i) {
+            bench.addOrder(make(Side::SELL, OrderType::LIMIT, 100.0 + i * 0.01, 10, 0.0));
+        }
+        for (int i = 0; i < numStops; ++i) {
+            bench.addOrder(make(Side::BUY, OrderType::STOP, 0.0, 5, 100.0 + (i % sweepLevels) * 0.01));
+        }
+
+        uint64_t start = TscClock::ticks();
+        bench.addOrder(make(Side::BUY, OrderType::LIMIT, 100.0 + (sweepLevels - 1) * 0.01, 10 * sweepLevels, 0.0));
+        bench.matchOrders();
+        long elapsed = TscClock::elapsedNs(start, TscClock::ticks()) / 1000;
+
+        long fired = bench.triggeredStops();
+        cout << "\n===== STOP CASCADE BENCHMARK =====" << endl;
+        cout << "Stops Fired: " << fired << " / " << numStops << endl;
+        cout << "Trades: " << bench.tradeCount() << endl;
+        cout << "Total Time: " << elapsed << " us" << endl;
+        cout << "Per Fired Stop: " << (fired ? elapsed * 1000.0 / fired : 0.0) << " ns" << endl;
+        cout << "==================================" << endl;
+    }
+
+    // Runs a whole session in simulated time on this thread against a fresh engine.
+    // Agents wake on the event heap, decide an order and have it arrive after their own
+    // network latency; nothing sleeps and nothing depends on thread timing, so a seed
+    // reproduces the session exactly (compare the printed checksum).
+    void simulateSession(const SimConfig& config) {
+        MatchingEngine session;
+        session.configureThrottle(gate.settings());
+        session.setTradeEcho(false);
+
+        struct Agent {
+            mt19937 rng;
+            long latencyNs;
+            int remaining;
+            bool momentum;
+        };
+
+        mt19937 master(config.seed);
+        uniform_int_distribution<long> latencyDist(config.minLatencyNs, max(config.minLatencyNs, config.maxLatencyNs));
+        uniform_real_distribution<> priceDist(100.0, 110.0);
+        uniform_int_distribution<> qtyDist(1, 100);
+        uniform_int_distribution<> sideDist(0, 1);
+
+        EventScheduler scheduler;
+        vector<Agent> agents;
+        agents.reserve(config.agents);
+        for (int a = 0; a < config.agents; ++a) {
+            bool momentum = config.momentumEvery > 0 && a % config.momentumEvery == 0;
+            agents.push_back({mt19937(master()), latencyDist(master), config.ordersPerAgent, momentum});
+            long period = momentum ? config.momentumStepNs : config.clientThinkNs;
+            long firstWake = uniform_int_distribution<long>(0, max(1L, period) - 1)(agents.back().rng);
+            if (config.ordersPerAgent > 0) scheduler.schedule({firstWake, 0, a, false, Side::BUY, 0.0, 0});
+        }
+
+        long accepted = 0;
+        uint64_t start = TscClock::ticks();
+        while (!scheduler.empty()) {
+            SimEvent e = scheduler.pop();
+            Agent& agent = agents[e.agent];
+            if (e.arrival) {
+                OrderAck ack = session.placeOrderAt(e.time, e.side, OrderType::LIMIT, e.price, e.quantity, "AAPL", e.agent);
+                if (ack.result == IngressResult::ACCEPTED) ++accepted;
+                continue;
+            }
+
+            SimEvent order = {e.time + agent.latencyNs, 0, e.agent, true, Side::BUY, priceDist(agent.rng), 0};
+            long next;
+            if (agent.momentum) {
+                order.side = order.price > 105.0 ? Side::SELL : Side::BUY;
+                order.quantity = 10;
+                next = config.momentumStepNs;
+            } else {
+                order.side = sideDist(agent.rng) == 0 ? Side::BUY : Side::SELL;
+                order.quantity = qtyDist(agent.rng);
+                next = static_cast<long>(exponential_distribution<>(1.0 / config.clientThinkNs)(agent.rng));
+            }
+            scheduler.schedule(order);
+            if (--agent.remaining > 0) scheduler.schedule({e.time + next, 0, e.agent, false, Side::BUY, 0.0, 0});
+        }
+        long wall = TscClock::elapsedNs(start, TscClock::ticks()) / 1000000;
+
+        long totalOrders = static_cast<long>(config.agents) * config.ordersPerAgent;
+        cout << "\n===== SIMULATED SESSION =====" << endl;
+        cout << "Agents: " << config.agents << " | Seed: " << config.seed << endl;
+        cout << "Total Orders: " << totalOrders << " (accepted " << accepted << ")" << endl;
+        cout << "Trades: " << session.book.tradeCount() << endl;
+        cout << "Events: " << scheduler.scheduled() << endl;
+        cout << "Simulated Time: " << scheduler.clock() / 1000000.0 << " ms" << endl;
+        cout << "Wall Time: " << wall << " ms" << endl;
+        cout << "Trade Log Checksum: " << hex << session.book.tradeLogChecksum() << dec << endl;
         cout << "=============================" << endl;
     }
 
+    // Routes random aggressive orders across `numVenues` in-process venues (each slower
+    // than the last) while passive flow replenishes random venues, then times the
+    // consolidated-BBO update on its own.
+    void simulateRouter(int numVenues, int numOrders) {
+        Router<MatchPolicy> router;
+        router.setLatencyPenalty(0.05);
+        for (int v = 0; v < numVenues; ++v) {
+            router.addVenue({"VENUE" + to_string(v + 1), 50000L + 100000L * v});
+        }
+
+        mt19937 gen(7);
+        uniform_int_distribution<> venueDist(0, numVenues - 1);
+        uniform_int_distribution<> tickDist(1, 20);
+        uniform_int_distribution<> qtyDist(10, 200);
+        int nextId = 1;
+        auto rest = [&](int v, Side side, double price, int qty) {
+            router.book(v)->addOrder({.id = nextId++, .symbol = "AAPL", .side = side,
+                                      .type = OrderType::LIMIT, .quantity = qty, .price = price});
+            router.book(v)->matchOrders();
+            router.refreshQuote(v);
+        };
+        for (int v = 0; v < numVenues; ++v) {
+            for (int i = 0; i < 40; ++i) {
+                rest(v, Side::BUY, 100.0 - tickDist(gen) * 0.01, qtyDist(gen));
+                rest(v, Side::SELL, 100.0 + tickDist(gen) * 0.01, qtyDist(gen));
+            }
+        }
+
+        long children = 0, requested = 0, filled = 0;
+        double slippage = 0.0;
+        vector<long> venueFills(numVenues, 0);
+        uint64_t start = TscClock::ticks();
+        for (int i = 0; i < numOrders; ++i) {
+            for (int k = 0; k < 2; ++k) {
+                const ConsolidatedBbo& b = router.consolidated();
+                double mid = (b.bidVenue >= 0 && b.askVenue >= 0) ? (b.bidPrice + b.askPrice) / 2 : 100.0;
+                Side side = k == 0 ? Side::BUY : Side::SELL;
+                double price = side == Side::BUY ? mid - tickDist(gen) * 0.01 : mid + tickDist(gen) * 0.01;
+                rest(venueDist(gen), side, round(price * 100) / 100, qtyDist(gen) * 3);
+            }
+
+            const ConsolidatedBbo& b = router.consolidated();
+            if (b.bidVenue < 0 || b.askVenue < 0) continue;
+            Side side = i % 2 == 0 ? Side::BUY : Side::SELL;
+            double touch = side == Side::BUY ? b.askPrice : b.bidPrice;
+            double limit = side == Side::BUY ? touch + 0.05 : touch - 0.05;
+            int qty = qtyDist(gen) * 3;
+            RouteResult r = router.route(side, limit, qty, TscClock::nowNs());
+            requested += qty;
+            filled += r.filled;
+            children += static_cast<long>(r.children.size());
+            for (const ChildOrder& c : r.children) venueFills[c.venue] += c.filled;
+            if (r.filled > 0) slippage += (side == Side::BUY ? r.avgPrice - touch : touch - r.avgPrice) * r.filled;
+        }
+        long routeNs = TscClock::elapsedNs(start, TscClock::ticks());
+
+        // The consolidated BBO on its own: random quote changes against all venues.
+        const int updates = 1000000;
+        vector<TopOfBook> quotes(1024);
+        for (auto& q : quotes) q = {100.0 - tickDist(gen) * 0.01, qtyDist(gen), 100.0 + tickDist(gen) * 0.01, qtyDist(gen)};
+        uint64_t bboStart = TscClock::ticks();
+        for (int i = 0; i < updates; ++i) router.onQuote(i % numVenues, quotes[i & 1023]);
+        double nsPerUpdate = TscClock::elapsedNs(bboStart, TscClock::ticks()) / static_cast<double>(updates);
+
+        stringstream report;
+        report << fixed << setprecision(4);
+        report << "\n===== ROUTER SIMULATION =====" << endl;
+        report << "Venues: " << numVenues << " | Parent Orders: " << numOrders << " | Children: " << children << endl;
+        report << "Filled: " << filled << " / " << requested << " shares" << endl;
+        for (int v = 0; v < numVenues; ++v) {
+            report << "  " << router.venue(v).name << " (" << router.venue(v).latencyNs / 1000 << " us): "
+                   << venueFills[v] << " shares" << endl;
+        }
+        report << "Avg Slippage vs Touch: $" << (filled > 0 ? slippage / filled : 0.0) << endl;
+        report << "Routing Time: " << routeNs / 1000 << " us" << endl;
+        report << "Consolidated BBO Update: " << setprecision(1) << nsPerUpdate << " ns ("
+               << router.quoteUpdateCount() << " updates)" << endl;
+        report << "=============================";
+        cout << report.str() << endl;
+    }
+
     void replayMarketData(const string& filename) {
         ifstream file(filename);
         string line;
@@ -182,30 +526,125 @@ public:
     }
 
     void runMomentumStrategy(int steps = 100) {
-        default_random_engine gen(random_device{}());
+        default_random_engine gen(drawSeed());
         uniform_real_distribution<> priceDist(100.0, 110.0);
 
         for (int i = 0; i < steps; ++i) {
             double price = priceDist(gen);
-            Side side = price > 105.0 ? Side::SELL : Side::BUY;
+            // Fade prices away from the last second's VWAP; before any trades, the mid of the range.
+            WindowStats recent = book.withTape([&](TradeTape& tape) { return tape.window(momentumWindow); });
+            double fair = recent.volume > 0 ? recent.vwap : 105.0;
+            Side side = price > fair ? Side::SELL : Side::BUY;
             placeOrder(side, OrderType::LIMIT, price, 10);
             this_thread::sleep_for(milliseconds(5));
         }
     }
 
+    void printBars(int count) {
+        stringstream out;
+        out << fixed << setprecision(2);
+        book.withTape([&](TradeTape& tape) {
+            const vector<Bar>& bars = tape.timeBars().all();
+            double tick = tape.tick();
+            out << "Trades on tape: " << tape.size() << endl;
+            out << "Last " << min<size_t>(count, bars.size()) << " one-second bars (OHLC, volume, VWAP):" << endl;
+            for (size_t i = bars.size() - min<size_t>(count, bars.size()); i < bars.size(); ++i) {
+                const Bar& b = bars[i];
+                out << "  " << b.open * tick << " " << b.high * tick << " " << b.low * tick << " " << b.close * tick
+                    << " | " << b.volume << " @ " << (b.volume > 0 ? b.notional * tick / b.volume : 0.0) << endl;
+            }
+            VolumeStats volumeBars = tape.volumeBars().last(count, tick);
+            out << "Last " << count << " volume bars: " << volumeBars.volume << " shares, " << volumeBars.trades
+                << " trades, VWAP " << volumeBars.vwap << endl;
+            WindowStats w = tape.window(momentumWindow);
+            out << "Rolling 1s: O " << w.open << " H " << w.high << " L " << w.low << " C " << w.close
+                << " | " << w.volume << " shares, VWAP " << w.vwap << endl;
+            return 0;
+        });
+        cout << out.str();
+    }
+
     void run() {
         string cmd;
         while (true) {
-            cout << "\nEnter Command (buy/sell/show/sim/replay/strat/exit): ";
+            cout << "\nEnter Command (buy/sell/stop/cancel/show/sim/dsim/stopsim/route/replay/strat/auction/uncross/throttle/stats/bars/replicas/hash/journal/trace/exit): ";
             cin >> cmd;
             if (cmd == "buy" || cmd == "sell") {
                 double price;
                 int qty;
                 cout << "Price: "; cin >> price;
                 cout << "Qty: "; cin >> qty;
-                placeOrder(cmd == "buy" ? Side::BUY : Side::SELL, OrderType::LIMIT, price, qty);
+                printAck(placeOrder(cmd == "buy" ? Side::BUY : Side::SELL, OrderType::LIMIT, price, qty));
+            } else if (cmd == "stop") {
+                string side;
+                double stopPrice, limitPrice;
+                int qty;
+                cout << "Side (buy/sell): "; cin >> side;
+                cout << "Stop price: "; cin >> stopPrice;
+                cout << "Limit price (0 = market): "; cin >> limitPrice;
+                cout << "Qty: "; cin >> qty;
+                printAck(placeStopOrder(side == "buy" ? Side::BUY : Side::SELL, stopPrice, limitPrice, qty));
+            } else if (cmd == "dsim") {
+                SimConfig config;
+                long minLatencyUs, maxLatencyUs;
+                cout << "# Agents: "; cin >> config.agents;
+                cout << "Orders per agent: "; cin >> config.ordersPerAgent;
+                cout << "Min latency (us): "; cin >> minLatencyUs;
+                cout << "Max latency (us): "; cin >> maxLatencyUs;
+                cout << "Seed: "; cin >> config.seed;
+                config.minLatencyNs = minLatencyUs * 1000;
+                config.maxLatencyNs = maxLatencyUs * 1000;
+                simulateSession(config);
+            } else if (cmd == "route") {
+                int venues, orders;
+                cout << "# Venues: "; cin >> venues;
+                cout << "# Parent orders: "; cin >> orders;
+                if (venues > 0) simulateRouter(venues, orders);
+            } else if (cmd == "stopsim") {
+                int stops;
+                cout << "# Stops: "; cin >> stops;
+                benchmarkStopCascade(stops);
+            } else if (cmd == "cancel") {
+                int id;
+                cout << "Order ID: "; cin >> id;
+                cout << (cancelOrder(id) ? "Cancelled" : "Unknown order") << endl;
+            } else if (cmd == "throttle") {
+                ThrottleConfig config;
+                cout << "Orders/sec per client (0 = off): "; cin >> config.ratePerClient;
+                cout << "Burst: "; cin >> config.burst;
+                cout << "Queue high watermark (0 = off): "; cin >> config.highWatermark;
+                cout << "Queue low watermark: "; cin >> config.lowWatermark;
+                configureThrottle(config);
+            } else if (cmd == "trace") {
+                string file;
+                cout << "Enter file path: "; cin >> file;
+                if (!FALCONEX_TRACE) cout << "Tracing not compiled in (configure with -DFALCONEX_TRACE=ON)." << endl;
+                long events = Tracer::dumpChromeTrace(file);
+                cout << "Wrote " << events << " trace events to " << file << endl;
+            } else if (cmd == "bars") {
+                printBars(10);
+            } else if (cmd == "hash") {
+                printSequencing();
+            } else if (cmd == "journal") {
+                string file;
+                cout << "Enter file path: "; cin >> file;
+                writeJournalFile(file);
+            } else if (cmd == "stats") {
+                gate.printStats();
+            } else if (cmd == "replicas") {
+                printReplicaStats();
             } else if (cmd == "show") {
-                book.printBook();
+                if (replicas.empty()) book.printBook(); else replicas[0]->printBook();
+                if (book.tradingPhase() == TradingPhase::AUCTION) {
+                    UncrossResult indicative = book.indicativeUncross();
+                    cout << "Indicative: " << indicative.volume << " @ $" << indicative.price
+                         << " (imbalance " << indicative.imbalance << ")" << endl;
+                }
+            } else if (cmd == "auction") {
+                beginAuction();
+                cout << "Call period open; orders will rest until uncross." << endl;
+            } else if (cmd == "uncross") {
+                runUncross();
             } else if (cmd == "sim") {
                 int threads, orders;
                 cout << "# Threads: "; cin >> threads;
@@ -219,18 +658,77 @@ public:
                 runMomentumStrategy();
             } else if (cmd == "exit") {
                 book.exportLog("trades.txt");
+                gate.exportStats("ingress_stats.txt");
                 break;
             }
         }
     }
 };
 
-int main() {
-    MatchingEngine engine;
+struct RunOptions {
+    string metricsName = "/falconex";
+    int replicaCount = 0;
+    bool sequenced = false;
+    unsigned seed = 0;
+    WaitMode waitMode = WaitMode::BLOCK;
+    int engineCpu = -1;       // the CLI thread, which runs matching for its own commands
+    vector<int> gatewayCpus;
+    vector<int> replicaCpus;
+    bool hugePages = true;
+};
+
+template <typename MatchPolicy>
+int runEngine(const RunOptions& options) {
+    if (options.engineCpu >= 0 && !pinThisThread(options.engineCpu)) {
+        cerr << "cannot pin engine thread to CPU " << options.engineCpu << "\n";
+    }
+    MetricsRegion metrics;
+    if (metrics.create(options.metricsName)) {
+        cout << "Metrics page: " << options.metricsName << " (watch with falconex_stat)" << endl;
+    } else {
+        cerr << "shared memory unavailable, metrics stay in-process\n";
+    }
+    HugePageResource hugePages;  // declared before the engine: outlives the book
+    std::pmr::memory_resource* bookMemory = std::pmr::get_default_resource();
+    if (options.hugePages) {
+        cout << "Book memory: 2 MB slabs from " << pageBackingName(hugePages.reserve()) << endl;
+        bookMemory = &hugePages;
+    }
+    MatchingEngine<MatchPolicy> engine(bookMemory);
+    engine.attachMetrics(metrics.get());
+    engine.setWaitMode(options.waitMode);
+    engine.setThreadCpus(options.gatewayCpus, options.replicaCpus);
+    engine.startReplicas(options.replicaCount);
+    engine.setSeed(options.seed);
+    if (options.sequenced) engine.enableSequencing();
     engine.run();
     return 0;
 }
 
+int main(int argc, char** argv) {
+    string match = "fifo";
+    RunOptions options;
+    for (int i = 1; i < argc; ++i) {
+        string a = argv[i];
+        if (a == "--match" && i + 1 < argc) match = argv[++i];
+        else if (a == "--metrics" && i + 1 < argc) options.metricsName = argv[++i];
+        else if (a == "--replicas" && i + 1 < argc) options.replicaCount = stoi(argv[++i]);
+        else if (a == "--sequenced") options.sequenced = true;
+        else if (a == "--seed" && i + 1 < argc) options.seed = static_cast<unsigned>(stoul(argv[++i]));
+        else if (a == "--wait" && i + 1 < argc) {
+            if (!parseWaitMode(argv[++i], options.waitMode)) cerr << "unknown wait mode " << argv[i] << "\n";
+        } else if (a == "--pin-engine" && i + 1 < argc) options.engineCpu = stoi(argv[++i]);
+        else if (a == "--pin-gateways" && i + 1 < argc) options.gatewayCpus = parseCpuList(argv[++i]);
+        else if (a == "--pin-replicas" && i + 1 < argc) options.replicaCpus = parseCpuList(argv[++i]);
+        else if (a == "--no-huge-pages") options.hugePages = false;
+        else cerr << "unknown arg " << a << "\n";
+    }
+    if (match == "prorata") return runEngine<ProRataMatch<>>(options);
+    if (match == "top-prorata") return runEngine<TopOrderProRataMatch<>>(options);
+    if (match != "fifo") cerr << "unknown matching policy " << match << ", using fifo\n";
+    return runEngine<FifoMatch>(options);
+}
+
 /*
 Sample Output: 
 /Users/islomshamsiev/CLionProjects/FalconEx/cmake-build-debug/FalconEx
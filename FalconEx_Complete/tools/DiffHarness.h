@@ -0,0 +1,172 @@
+#pragma once
+// Differential harness: feeds one sequenced input stream to a reference book and a
+// candidate book and reports the first input whose output differs (result, trades or
+// top of book). The stream is either generated from a seed (limit, market and stop
+// orders, cancels, modifies and the odd call auction around a drifting mid) or read
+// from a journal written by `falconex --sequenced` (`journal` command); an expected
+// hash is checked against the final output hash the engine printed (`hash` command).
+//
+// diffBooks() takes the two books by type, so any book with OrderBook's public
+// interface can be checked against OrderBook<FifoMatch> from a small driver of its own:
+//
+//   DiffOptions opts;
+//   std::vector<SequencedInput> inputs;
+//   if (!parseDiffOptions(argc, argv, opts) || !loadDiffInputs(opts, inputs)) return 2;
+//   OrderBook<FifoMatch> reference;
+//   MyBook candidate;
+//   return diffBooks(reference, candidate, inputs, opts.expect);
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "Clock.h"
+#include "OrderBook.h"
+#include "Sequencer.h"
+
+struct DiffOptions {
+    unsigned seed = 42;
+    long count = 200000;
+    std::string reference = "fifo";  // policy names, used by falconex_diff only
+    std::string candidate = "fifo";
+    std::string journalPath;
+    std::string savePath;
+    std::string expect;
+};
+
+// Returns false on an unknown or incomplete argument.
+inline bool parseDiffOptions(int argc, char** argv, DiffOptions& opts) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--seed" && i + 1 < argc) opts.seed = static_cast<unsigned>(std::stoul(argv[++i]));
+        else if (a == "--inputs" && i + 1 < argc) opts.count = std::stol(argv[++i]);
+        else if (a == "--reference" && i + 1 < argc) opts.reference = argv[++i];
+        else if (a == "--candidate" && i + 1 < argc) opts.candidate = argv[++i];
+        else if (a == "--journal" && i + 1 < argc) opts.journalPath = argv[++i];
+        else if (a == "--save" && i + 1 < argc) opts.savePath = argv[++i];
+        else if (a == "--expect" && i + 1 < argc) opts.expect = argv[++i];
+        else return false;
+    }
+    return true;
+}
+
+inline std::vector<SequencedInput> generateDiffStream(unsigned seed, long count) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<> percent(0, 99);
+    std::uniform_int_distribution<> qtyDist(1, 100);
+    std::uniform_int_distribution<> offsetDist(-3, 20);  // ticks away from mid; negative crosses
+    std::vector<SequencedInput> inputs;
+    std::vector<int> ids;
+    inputs.reserve(count);
+    long midTicks = 10500;
+    int nextId = 1;
+    bool auction = false;
+
+    for (long n = 0; n < count; ++n) {
+        midTicks += static_cast<int>(rng() % 3) - 1;
+        SequencedInput in{static_cast<std::uint64_t>(n + 1), InputType::ADD, {}, 0, 0.0, 0};
+        int roll = percent(rng);
+        if (auction && percent(rng) < 2) {
+            in.type = InputType::UNCROSS;
+            auction = false;
+        } else if (!auction && rng() % 2000 == 0) {
+            in.type = InputType::AUCTION;
+            auction = true;
+        } else if (roll < 22 && !ids.empty()) {
+            in.type = InputType::CANCEL;
+            in.orderId = ids[rng() % ids.size()];
+        } else if (roll < 34 && !ids.empty()) {
+            in.type = InputType::MODIFY;
+            in.orderId = ids[rng() % ids.size()];
+            in.newPrice = (midTicks + offsetDist(rng)) / 100.0;
+            in.newQty = qtyDist(rng);
+        } else {
+            Order& o = in.order;
+            o.id = nextId++;
+            o.symbol = "AAPL";
+            o.side = rng() % 2 == 0 ? Side::BUY : Side::SELL;
+            o.quantity = qtyDist(rng);
+            o.timestamp = (n + 1) * 1000;
+            o.clientId = static_cast<int>(rng() % 64);
+            int sign = o.side == Side::BUY ? -1 : 1;  // passive offsets move away from mid
+            if (roll < 42) {
+                o.type = OrderType::MARKET;
+                o.quantity = 1 + o.quantity / 2;
+            } else if (roll < 48) {
+                o.type = percent(rng) < 50 ? OrderType::STOP : OrderType::STOP_LIMIT;
+                o.stopPrice = (midTicks - sign * (5 + static_cast<int>(rng() % 30))) / 100.0;
+                if (o.type == OrderType::STOP_LIMIT) o.price = o.stopPrice - sign * 0.05;
+            } else {
+                o.type = OrderType::LIMIT;
+                o.price = (midTicks + sign * offsetDist(rng)) / 100.0;
+            }
+            ids.push_back(o.id);
+        }
+        inputs.push_back(std::move(in));
+    }
+    return inputs;
+}
+
+// The journal if one was given, otherwise the seeded stream; saved if asked.
+inline bool loadDiffInputs(const DiffOptions& opts, std::vector<SequencedInput>& inputs) {
+    if (!opts.journalPath.empty()) {
+        if (!readJournal(opts.journalPath, inputs)) {
+            std::cerr << "cannot read journal " << opts.journalPath << "\n";
+            return false;
+        }
+    } else {
+        inputs = generateDiffStream(opts.seed, opts.count);
+    }
+    if (!opts.savePath.empty() && !writeJournal(opts.savePath, inputs)) std::cerr << "cannot write " << opts.savePath << "\n";
+    return true;
+}
+
+inline void printDiffStep(const char* label, const StepOutput& step) {
+    std::cout << "  " << label << ": result " << step.result << ", " << step.trades.size() << " trades" << std::endl;
+    for (const TradeRow& t : step.trades) {
+        std::cout << "    " << t.quantity << " @ " << t.priceTicks << " ticks, buy #" << t.buyOrderId << " / sell #"
+                  << t.sellOrderId << std::endl;
+    }
+}
+
+inline void printDiffInput(const SequencedInput& in) {
+    static const char* names[] = {"ADD", "CANCEL", "MODIFY", "AUCTION", "UNCROSS"};
+    std::cout << "  input: " << names[static_cast<int>(in.type)];
+    if (in.type == InputType::ADD) {
+        std::cout << " #" << in.order.id << (in.order.side == Side::BUY ? " buy " : " sell ") << in.order.quantity
+                  << " @ " << in.order.price;
+    } else if (in.type != InputType::AUCTION && in.type != InputType::UNCROSS) {
+        std::cout << " #" << in.orderId;
+    }
+    std::cout << std::endl;
+}
+
+// Runs both books over the inputs and reports. Returns the process exit code: 0 when
+// they agree (and the hash matches `expect`, if given), 1 otherwise. The books should
+// start empty, with trade echo off.
+template <typename ReferenceBook, typename CandidateBook>
+int diffBooks(ReferenceBook& reference, CandidateBook& candidate, const std::vector<SequencedInput>& inputs,
+              const std::string& expect) {
+    std::uint64_t hash = 0;
+    std::uint64_t start = TscClock::ticks();
+    Divergence d = findDivergence(reference, candidate, inputs, &hash);
+    double secs = TscClock::elapsedNs(start, TscClock::ticks()) / 1e9;
+
+    if (d.found) {
+        std::cout << "DIVERGED at seq " << d.seq << " after " << d.outputEvents << " matching output events" << std::endl;
+        printDiffInput(inputs[d.seq - 1]);
+        printDiffStep("reference", d.reference);
+        printDiffStep("candidate", d.candidate);
+        return 1;
+    }
+    std::size_t trades = reference.withTape([](TradeTape& tape) { return tape.size(); });
+    std::cout << "Identical: " << inputs.size() << " inputs, " << trades << " trades, " << d.outputEvents
+              << " output events in " << std::fixed << std::setprecision(2) << secs << " s" << std::endl;
+    std::cout << "Output hash: " << std::hex << hash << std::dec << std::endl;
+    if (!expect.empty() && std::stoull(expect, nullptr, 16) != hash) {
+        std::cout << "Hash differs from expected " << expect << std::endl;
+        return 1;
+    }
+    return 0;
+}
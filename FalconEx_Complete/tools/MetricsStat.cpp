@@ -0,0 +1,113 @@
+// vmstat for FalconEx: samples the engine's shared-memory metrics page at a fixed
+// interval and prints per-second rates for counters and current values for gauges.
+// With --prom the latest sample is also written as Prometheus text exposition (for
+// node_exporter's textfile collector or a quick curl-less scrape).
+//
+//   falconex_stat [--name /falconex] [--interval-ms 1000] [--count 0] [--prom metrics.prom]
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <signal.h>
+#include <string>
+#include <thread>
+#include "Metrics.h"
+
+using namespace std;
+
+struct Sample {
+    uint64_t values[METRIC_COUNT];
+    chrono::steady_clock::time_point at;
+};
+
+static Sample takeSample(const MetricsPage& page) {
+    Sample s;
+    for (int m = 0; m < METRIC_COUNT; ++m) s.values[m] = page.get(static_cast<Metric>(m));
+    s.at = chrono::steady_clock::now();
+    return s;
+}
+
+// Written to a temporary file and renamed, so a scraper never reads half a sample.
+static bool writePrometheus(const string& path, const Sample& s) {
+    string tmp = path + ".tmp";
+    {
+        ofstream out(tmp);
+        if (!out) return false;
+        for (int m = 0; m < METRIC_COUNT; ++m) {
+            const MetricInfo& info = metricInfo(static_cast<Metric>(m));
+            out << "# HELP " << info.name << " " << info.help << "\n";
+            out << "# TYPE " << info.name << " " << (info.gauge ? "gauge" : "counter") << "\n";
+            out << info.name << " " << static_cast<int64_t>(s.values[m]) << "\n";
+        }
+    }
+    return rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+static void printHeader() {
+    cout << setw(9) << "ord/s" << setw(8) << "thr/s" << setw(8) << "shed/s" << setw(8) << "cxl/s"
+         << setw(9) << "trd/s" << setw(10) << "qty/s" << setw(7) << "inflt" << setw(7) << "bids"
+         << setw(7) << "asks" << setw(9) << "resting" << setw(7) << "stops" << setw(7) << "cont%"
+         << setw(8) << "rlag" << setw(9) << "rlag_us" << endl;
+}
+
+static void printRow(const Sample& prev, const Sample& cur) {
+    double secs = chrono::duration<double>(cur.at - prev.at).count();
+    auto rate = [&](Metric m) {
+        return secs > 0.0 ? static_cast<long>((cur.values[m] - prev.values[m]) / secs) : 0L;
+    };
+    auto gauge = [&](Metric m) { return static_cast<int64_t>(cur.values[m]); };
+    uint64_t acquired = cur.values[LOCK_ACQUIRED] - prev.values[LOCK_ACQUIRED];
+    uint64_t contended = cur.values[LOCK_CONTENDED] - prev.values[LOCK_CONTENDED];
+    double contention = acquired ? 100.0 * contended / acquired : 0.0;
+
+    cout << setw(9) << rate(ORDERS_ACCEPTED) << setw(8) << rate(ORDERS_THROTTLED)
+         << setw(8) << rate(ORDERS_SHED) << setw(8) << rate(CANCELS) << setw(9) << rate(TRADES)
+         << setw(10) << rate(TRADED_QTY) << setw(7) << gauge(INGRESS_DEPTH) << setw(7) << gauge(BID_LEVELS)
+         << setw(7) << gauge(ASK_LEVELS) << setw(9) << gauge(RESTING_ORDERS) << setw(7) << gauge(PENDING_STOPS)
+         << setw(7) << fixed << setprecision(1) << contention << setw(8) << gauge(REPLICA_LAG_EVENTS)
+         << setw(9) << gauge(REPLICA_LAG_NS) / 1000 << endl;
+}
+
+int main(int argc, char** argv) {
+    string name = "/falconex";
+    string promPath;
+    long intervalMs = 1000;
+    long count = 0;
+    for (int i = 1; i < argc; ++i) {
+        string a = argv[i];
+        if (a == "--name" && i + 1 < argc) name = argv[++i];
+        else if (a == "--interval-ms" && i + 1 < argc) intervalMs = stol(argv[++i]);
+        else if (a == "--count" && i + 1 < argc) count = stol(argv[++i]);
+        else if (a == "--prom" && i + 1 < argc) promPath = argv[++i];
+        else {
+            cerr << "usage: falconex_stat [--name /falconex] [--interval-ms 1000] [--count N] [--prom FILE]\n";
+            return 2;
+        }
+    }
+
+    MetricsRegion region;
+    string error;
+    if (!region.attach(name, error)) {
+        cerr << error << "\n";
+        return 1;
+    }
+    const MetricsPage& page = *region.get();
+
+    Sample prev = takeSample(page);
+    for (long n = 0; count == 0 || n < count; ++n) {
+        this_thread::sleep_for(chrono::milliseconds(intervalMs));
+        Sample cur = takeSample(page);
+        if (n % 20 == 0) printHeader();
+        printRow(prev, cur);
+        if (!promPath.empty() && !writePrometheus(promPath, cur)) {
+            cerr << "cannot write " << promPath << "\n";
+        }
+        prev = cur;
+        if (kill(static_cast<pid_t>(page.pid), 0) != 0 && errno == ESRCH) {
+            cerr << "engine (pid " << page.pid << ") has exited\n";
+            break;
+        }
+    }
+    return 0;
+}
@@ -1,4 +1,102 @@
-// Placeholder for IPC client (q <-> C++).
-// For a full IPC integration, include k.h from your QHOME and use the kdb+ C API.
-// This demo uses file-based exchange for simplicity.
-int main(){ return 0; }
+// q <-> C++ bridge over kdb+ IPC, no files in between: pulls a window of quotes from a
+// q server with .api.getWindow, runs the fill model on them and sends the fills back
+// as a table with .api.putFills. Serve q/server.q from q, or use kdbq_standin.
+//
+//   kdbq_client --port 5000 --sym DEMO --from 2025.09.03D09:30:00 --to 2025.09.03D16:00:00
+//               --orders orders.csv [--host localhost] [--auth user:pass] [--compress]
+//               [--latency_ticks N] [--slip_bps B] [--bench-csv quotes.csv]
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Engine.h"
+#include "FillModel.h"
+#include "Loaders.h"
+#include "Timestamp.h"
+#include "EngineTables.h"
+#include "KdbIpc.h"
+
+using namespace std;
+
+static int64_t tsArg(const string& s) {
+    int64_t ns;
+    if (!parseTimestamp(s, ns)) throw runtime_error("bad timestamp "+s);
+    return ns;
+}
+
+int main(int argc, char** argv) {
+    ios::sync_with_stdio(false);
+    string host="localhost", auth, sym, ordersPath, benchCsv;
+    int port=5000;
+    int64_t from=0, to=0;
+    bool haveFrom=false, haveTo=false, compress=false;
+    EngineParams params;
+    for (int i=1;i<argc;i++){
+        string a=argv[i];
+        auto get=[&](string k){ if(i+1>=argc) throw runtime_error("missing "+k); return string(argv[++i]); };
+        if (a=="--host") host=get("--host");
+        else if (a=="--port") port=stoi(get("--port"));
+        else if (a=="--auth") auth=get("--auth");
+        else if (a=="--sym") sym=get("--sym");
+        else if (a=="--from") { from=tsArg(get("--from")); haveFrom=true; }
+        else if (a=="--to") { to=tsArg(get("--to")); haveTo=true; }
+        else if (a=="--orders") ordersPath=get("--orders");
+        else if (a=="--latency_ticks") params.latency_ticks=stoi(get("--latency_ticks"));
+        else if (a=="--slip_bps") params.slip_bps=stod(get("--slip_bps"));
+        else if (a=="--compress") compress=true;
+        else if (a=="--bench-csv") benchCsv=get("--bench-csv");
+        else cerr<<"unknown arg "<<a<<"\n";
+    }
+    if (sym.empty()||!haveFrom||!haveTo||ordersPath.empty()) {
+        cerr<<"Usage: kdbq_client --sym S --from TS --to TS --orders <orders.csv> [--host H] [--port 5000] [--auth user:pass] [--compress] [--latency_ticks N] [--slip_bps B] [--bench-csv quotes.csv]\n";
+        return 2;
+    }
+
+    KConnection q(host, port, auth);
+
+    // .api.getWindow[sym;from;to] -> quotes table, decoded straight into columns
+    auto t0 = chrono::steady_clock::now();
+    KWriter call;
+    call.listHeader(0, 4);
+    call.symAtom(".api.getWindow");
+    call.symAtom(sym);
+    call.timestampAtom(from);
+    call.timestampAtom(to);
+    vector<char> reply = q.call(call);
+    KReader r(reply.data()+8, reply.size()-8);
+    QuoteColumns quotes = quotesFromTable(r.read());
+    if (!is_sorted(quotes.ts.begin(), quotes.ts.end())) throw runtime_error("quotes from q not sorted by ts");
+    double ipcSecs = chrono::duration<double>(chrono::steady_clock::now()-t0).count();
+    reportLoad("quotes over IPC", quotes.size(), reply.size(), t0);
+    vector<char>().swap(reply);
+
+    if (!benchCsv.empty()) {
+        auto t1 = chrono::steady_clock::now();
+        QuoteColumns csv = parseQuotes(benchCsv);
+        double csvSecs = chrono::duration<double>(chrono::steady_clock::now()-t1).count();
+        cerr<<"IPC vs CSV: "<<fixed<<setprecision(3)<<ipcSecs<<" s vs "<<csvSecs<<" s for "<<quotes.size()<<" / "
+            <<csv.size()<<" quotes\n"<<defaultfloat;
+    }
+
+    auto orders = loadOrders(ordersPath);
+    FillModel model(quotes, params);
+    vector<Fill> fills = model.run(orders);
+
+    // .api.putFills[fills]
+    t0 = chrono::steady_clock::now();
+    KWriter put;
+    put.listHeader(0, 2);
+    put.symAtom(".api.putFills");
+    writeFillsTable(put, fills);
+    size_t bytes = put.size();
+    vector<char> ack = q.call(put, compress);
+    KReader ar(ack.data()+8, ack.size()-8);
+    int64_t held = ar.read().asLong();
+    cerr<<"Sent "<<fills.size()<<" fills ("<<bytes<<" bytes"<<(compress ? ", compression on" : "")<<") in "<<fixed
+        <<setprecision(3)<<chrono::duration<double>(chrono::steady_clock::now()-t0).count()<<" s; server holds "
+        <<held<<"\n"<<defaultfloat;
+    return 0;
+}
@@ -0,0 +1,77 @@
+#pragma once
+// Engine data <-> q tables over IPC. Quotes travel as
+//   ([] ts:timestamp; sym:symbol; bid:float; ask:float; bsz:int; asz:int)
+// (the quotes schema of ingest.q / .api.getWindow) and fills as
+//   ([] ts:timestamp; order_id:long; side:symbol; px:float; qty:int; liq:symbol).
+// Typed columns are copied straight between the message buffer and engine columns.
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "BookView.h"
+#include "Engine.h"
+#include "KdbIpc.h"
+
+inline void writeQuotesTable(KWriter& w, const QuoteColumns& q, size_t from, size_t to, const std::string& sym) {
+    size_t n = to-from;
+    w.reserve(n*(8+sym.size()+1+2*8+2*4)+64);
+    w.tableHeader({"ts","sym","bid","ask","bsz","asz"});
+    w.timestampVector(q.ts.data()+from, n);
+    w.listHeader(KS, n);
+    for (size_t i=0;i<n;i++) w.sym(sym);
+    w.vector(KF, q.bid.data()+from, n);
+    w.vector(KF, q.ask.data()+from, n);
+    w.vector(KI, q.bsz.data()+from, n);
+    w.vector(KI, q.asz.data()+from, n);
+}
+
+// ts may be timestamp; prices float or real; sizes int or long.
+inline QuoteColumns quotesFromTable(const KView& t) {
+    if (t.type!=KTABLE) throw std::runtime_error("expected a quotes table, got type "+std::to_string(t.type));
+    auto col = [&](const char* name) -> const KView& {
+        const KView* c = t.column(name);
+        if (!c) throw std::runtime_error(std::string("quotes table has no column ")+name);
+        return *c;
+    };
+    const KView &ts = col("ts"), &bid = col("bid"), &ask = col("ask"), &bsz = col("bsz"), &asz = col("asz");
+    const size_t n = ts.n;
+    if (bid.n!=n || ask.n!=n || bsz.n!=n || asz.n!=n) throw std::runtime_error("quotes table columns differ in length");
+    if (ts.type!=KP) throw std::runtime_error("quotes ts must be timestamp");
+    QuoteBuilder b;
+    b.ts.resize(n); b.bid.resize(n); b.ask.resize(n); b.bsz.resize(n); b.asz.resize(n);
+    for (size_t i=0;i<n;i++) { int64_t x; memcpy(&x, ts.data+8*i, 8); b.ts[i]=x+kQEpochNs; }
+    auto prices = [&](const KView& c, Column<double>& out){
+        if (c.type==KF) { memcpy(out.data(), c.data, 8*n); return; }
+        if (c.type!=KE) throw std::runtime_error("quote prices must be float or real");
+        for (size_t i=0;i<n;i++) { float x; memcpy(&x, c.data+4*i, 4); out[i]=x; }
+    };
+    auto sizes = [&](const KView& c, Column<int32_t>& out){
+        if (c.type==KI) { memcpy(out.data(), c.data, 4*n); }
+        else if (c.type==KJ) { for (size_t i=0;i<n;i++) { int64_t x; memcpy(&x, c.data+8*i, 8); out[i]=(int32_t)x; } }
+        else throw std::runtime_error("quote sizes must be int or long");
+        for (auto& x : out) if (x==INT32_MIN) x=0; // 0N
+    };
+    prices(bid, b.bid); prices(ask, b.ask);
+    sizes(bsz, b.bsz); sizes(asz, b.asz);
+    return QuoteColumns(std::move(b));
+}
+
+inline void writeFillsTable(KWriter& w, const std::vector<Fill>& fills) {
+    size_t n = fills.size();
+    std::vector<int64_t> ts(n), id(n);
+    std::vector<double> px(n);
+    std::vector<int32_t> qty(n);
+    std::vector<std::string> side(n), liq(n);
+    for (size_t i=0;i<n;i++) {
+        const Fill& f = fills[i];
+        ts[i]=f.ts; id[i]=f.order_id; px[i]=f.px; qty[i]=f.qty; side[i]=f.side; liq[i]=f.liq;
+    }
+    w.tableHeader({"ts","order_id","side","px","qty","liq"});
+    w.timestampVector(ts.data(), n);
+    w.vector(KJ, id.data(), n);
+    w.symVector(side);
+    w.vector(KF, px.data(), n);
+    w.vector(KI, qty.data(), n);
+    w.symVector(liq);
+}
@@ -0,0 +1,44 @@
+#pragma once
+// The part of kdb+'s C API (k.h, KXVER 3) that the in-process library uses: the K
+// object layout, element accessors, and the constructors exported by the q binary.
+// Declared here so the library builds without a q install; when q loads it with 2:,
+// the functions resolve against q itself. Layout of a K object:
+//   m a t u | r:4 | n:8 | elements...      (atoms keep their value where n is)
+#include <cstdint>
+#include <cstring>
+#include "KTypes.h"
+
+extern "C" {
+typedef struct k0 {
+    signed char m, a, t; // t: type (negative for atoms)
+    unsigned char u;
+    int32_t r;           // reference count - 1
+    union {
+        unsigned char g; int16_t h; int32_t i; int64_t j; float e; double f; char* s; struct k0* k;
+        struct { int64_t n; unsigned char G0[1]; };
+    };
+} *K;
+
+K ktn(int32_t type, int64_t n);
+K xD(K keys, K values);
+K xT(K dict);
+K krr(char* s);
+char* ss(char* s);
+}
+
+inline unsigned char* kG(K x) { return x->G0; }
+inline int32_t* kI(K x) { return reinterpret_cast<int32_t*>(x->G0); }
+inline int64_t* kJ(K x) { return reinterpret_cast<int64_t*>(x->G0); }
+inline float* kE(K x) { return reinterpret_cast<float*>(x->G0); }
+inline double* kF(K x) { return reinterpret_cast<double*>(x->G0); }
+inline char** kS(K x) { return reinterpret_cast<char**>(x->G0); }
+inline K* kK(K x) { return reinterpret_cast<K*>(x->G0); }
+
+// Column of a table (type 98, a flipped dict of names to columns) by name, or nullptr.
+inline K kColumn(K table, const char* name) {
+    if (table->t!=KTABLE) return nullptr;
+    K d = table->k, names = kK(d)[0], cols = kK(d)[1];
+    for (int64_t i=0;i<names->n;i++)
+        if (strcmp(kS(names)[i], name)==0) return kK(cols)[i];
+    return nullptr;
+}
@@ -0,0 +1,325 @@
+#pragma once
+// Self-contained kdb+ IPC: TCP handshake, message framing, serialization of atoms,
+// vectors, lists, dictionaries and tables, and the IPC compression scheme (same
+// algorithm as kx's c.java / c.cs). Messages are little-endian; this code assumes a
+// little-endian host.
+//
+// Handshake: the client sends "user:password", a capability byte (3: compression and
+// timestamps) and a NUL; the server answers with one capability byte or closes.
+// Message: 8-byte header {endian=1, type (0 async, 1 sync, 2 response), compressed,
+// 0, total length:4} followed by one serialized object. Compressed messages carry the
+// uncompressed length at bytes 8..11 and the compressed stream after it.
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "KTypes.h"
+
+static_assert(std::endian::native==std::endian::little, "kdb+ IPC code assumes a little-endian host");
+
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL; // a dead peer is an error, not SIGPIPE
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+enum KMsgType : int { KASYNC=0, KSYNC=1, KRESPONSE=2 };
+
+// Builds one message. The header is filled in by message().
+class KWriter {
+    std::vector<char> b;
+public:
+    KWriter() : b(8, 0) {}
+
+    template<typename T> void put(T v) { raw(&v, sizeof v); }
+    void raw(const void* p, size_t n) { auto c = static_cast<const char*>(p); b.insert(b.end(), c, c+n); }
+    void sym(std::string_view s) { raw(s.data(), s.size()); b.push_back(0); }
+    void reserve(size_t n) { b.reserve(b.size()+n); }
+
+    void symAtom(std::string_view s) { put<int8_t>(-KS); sym(s); }
+    void longAtom(int64_t v) { put<int8_t>(-KJ); put(v); }
+    void timestampAtom(int64_t unixNs) { put<int8_t>(-KP); put<int64_t>(unixNs-kQEpochNs); }
+    void identity() { put<int8_t>(KUNARY); put<int8_t>(0); } // (::)
+    void error(std::string_view msg) { put<int8_t>((int8_t)KERROR); sym(msg); }
+
+    // Vector/general-list header; the elements follow.
+    void listHeader(int type, size_t n) {
+        if (n>INT32_MAX) throw std::runtime_error("kdb+ IPC: list too long");
+        put<int8_t>(type); put<int8_t>(0); put<int32_t>((int32_t)n);
+    }
+    template<typename T> void vector(int type, const T* data, size_t n) { listHeader(type, n); raw(data, n*sizeof(T)); }
+    void timestampVector(const int64_t* unixNs, size_t n) {
+        listHeader(KP, n);
+        size_t at = b.size();
+        b.resize(at+8*n);
+        for (size_t i=0;i<n;i++) { int64_t x = unixNs[i]-kQEpochNs; memcpy(b.data()+at+8*i, &x, 8); }
+    }
+    template<typename Range> void symVector(const Range& names) {
+        listHeader(KS, names.size());
+        for (const auto& s : names) sym(s);
+    }
+    // flip names!columns: write the header, then each column as a vector.
+    void tableHeader(const std::vector<std::string>& names) {
+        put<int8_t>(KTABLE); put<int8_t>(0); put<int8_t>(KDICT);
+        symVector(names);
+        listHeader(0, names.size());
+    }
+
+    size_t size() const { return b.size(); }
+
+    // The finished message; compressed when asked and it pays (q itself only
+    // compresses messages over 2000 bytes that shrink to under half).
+    std::vector<char> message(int msgType, bool compress=false);
+};
+
+// Compresses a whole message (header included); false when it would not halve it.
+inline bool kCompress(const std::vector<char>& y, std::vector<char>& out) {
+    const size_t t = y.size();
+    if (t<2000) return false;
+    out.assign(t/2, 0);
+    const size_t e = out.size();
+    uint8_t i=0;
+    int f=0, h0=0, h=0;
+    size_t c=12, d=12, p=0, q, r, s0=0, s=8, a[256]={};
+    memcpy(out.data(), y.data(), 4);
+    out[2] = 1;
+    uint32_t tl = (uint32_t)t; memcpy(out.data()+8, &tl, 4);
+    for (; s<t; i*=2) {
+        if (i==0) {
+            if (d>e-17) return false;
+            i=1; out[c]=(char)f; c=d++; f=0;
+        }
+        bool g = s>t-3;
+        if (!g) { h = (uint8_t)(y[s]^y[s+1]); p = a[h]; g = p==0 || y[s]!=y[p]; }
+        if (s0>0) { a[h0]=s0; s0=0; }
+        if (g) { h0=h; s0=s; out[d++]=y[s++]; }
+        else {
+            a[h]=s; f|=i; p+=2; r=s+=2; q=std::min(s+255, t);
+            while (y[p]==y[s] && ++s<q) ++p;
+            out[d++]=(char)h; out[d++]=(char)(s-r);
+        }
+    }
+    out[c]=(char)f;
+    uint32_t dl = (uint32_t)d; memcpy(out.data()+4, &dl, 4);
+    out.resize(d);
+    return true;
+}
+
+// Inverse of kCompress: the full uncompressed message, header included.
+inline std::vector<char> kDecompress(const char* b, size_t size) {
+    auto bad = []{ return std::runtime_error("kdb+ IPC: corrupt compressed message"); };
+    if (size<12) throw bad();
+    uint32_t n; memcpy(&n, b+8, 4);
+    if (n<8) throw bad();
+    std::vector<char> dst(n);
+    memcpy(dst.data(), b, 8);
+    dst[2] = 0;
+    memcpy(dst.data()+4, &n, 4);
+    size_t s=8, p=8, d=12, aa[256]={};
+    int i=0, f=0;
+    while (s<n) {
+        if (i==0) { if (d>=size) throw bad(); f=(uint8_t)b[d++]; i=1; }
+        size_t cnt=0;
+        if (f&i) {
+            if (d+2>size || s+2>n) throw bad();
+            size_t r = aa[(uint8_t)b[d++]];
+            dst[s++]=dst[r++]; dst[s++]=dst[r++];
+            cnt = (uint8_t)b[d++];
+            if (s+cnt>n) throw bad();
+            for (size_t m=0;m<cnt;m++) dst[s+m]=dst[r+m];
+        } else {
+            if (d>=size) throw bad();
+            dst[s++]=b[d++];
+        }
+        for (; p+1<s; p++) aa[(uint8_t)dst[p]^(uint8_t)dst[p+1]]=p;
+        if (f&i) p = s += cnt;
+        i*=2;
+        if (i==256) i=0;
+    }
+    return dst;
+}
+
+inline std::vector<char> KWriter::message(int msgType, bool compress) {
+    if (b.size()>INT32_MAX) throw std::runtime_error("kdb+ IPC: message too large");
+    b[0]=1; b[1]=(char)msgType; b[2]=0; b[3]=0;
+    uint32_t n = (uint32_t)b.size(); memcpy(b.data()+4, &n, 4);
+    std::vector<char> z;
+    if (compress && kCompress(b, z)) return z;
+    return b;
+}
+
+// A deserialized object. Nothing is copied: atoms and fixed-width vectors point into
+// the message buffer, which must outlive the view.
+struct KView {
+    int type{0};
+    uint64_t n{0};                      // vectors and lists: element count
+    const char* data{nullptr};          // atoms and fixed-width vectors: the raw elements
+    std::vector<std::string_view> syms; // symbol atom/vector; error text
+    std::vector<KView> items;           // general list; dict {keys, values}; table {names, columns}
+
+    // Column of a table by name, or nullptr.
+    const KView* column(std::string_view name) const {
+        if (type!=KTABLE || items.size()<2) return nullptr;
+        const KView& names = items[0];
+        for (size_t i=0;i<names.syms.size();i++)
+            if (names.syms[i]==name && i<items[1].items.size()) return &items[1].items[i];
+        return nullptr;
+    }
+    int64_t asLong() const {
+        if (type==-KJ) { int64_t v; memcpy(&v, data, 8); return v; }
+        if (type==-KI) { int32_t v; memcpy(&v, data, 4); return v; }
+        throw std::runtime_error("kdb+ IPC: expected a long, got type "+std::to_string(type));
+    }
+};
+
+class KReader {
+    const char* p;
+    const char* end;
+    void need(size_t n) const { if ((size_t)(end-p)<n) throw std::runtime_error("kdb+ IPC: truncated message"); }
+    std::string_view cstr() {
+        const char* z = static_cast<const char*>(memchr(p, 0, end-p));
+        if (!z) throw std::runtime_error("kdb+ IPC: unterminated symbol");
+        std::string_view s(p, z-p);
+        p = z+1;
+        return s;
+    }
+public:
+    KReader(const char* data, size_t size) : p(data), end(data+size) {}
+
+    KView read() {
+        need(1);
+        KView v;
+        v.type = (int8_t)*p++;
+        if (v.type==KERROR || v.type==-KS) { v.syms.push_back(cstr()); return v; }
+        if (v.type<0) {
+            size_t w = kTypeWidth(v.type);
+            if (w==0) throw std::runtime_error("kdb+ IPC: unsupported atom type "+std::to_string(v.type));
+            need(w); v.data=p; p+=w; v.n=1;
+            return v;
+        }
+        if (v.type==KTABLE) { need(1); p++; KView d = read(); v.items = std::move(d.items); return v; }
+        if (v.type==KDICT) { v.items.push_back(read()); v.items.push_back(read()); return v; }
+        if (v.type==KUNARY) { need(1); p++; return v; }
+        if (v.type>=KENUM) throw std::runtime_error("kdb+ IPC: unsupported type "+std::to_string(v.type));
+        need(5); // <attr> <count:4>
+        int32_t n; memcpy(&n, p+1, 4);
+        p += 5;
+        if (n<0) throw std::runtime_error("kdb+ IPC: bad list length");
+        v.n = (uint64_t)n;
+        if (v.type==0) { v.items.reserve(n); for (int32_t i=0;i<n;i++) v.items.push_back(read()); return v; }
+        if (v.type==KS) { v.syms.reserve(n); for (int32_t i=0;i<n;i++) v.syms.push_back(cstr()); return v; }
+        size_t w = kTypeWidth(v.type);
+        need(w*v.n);
+        v.data = p; p += w*v.n;
+        return v;
+    }
+};
+
+// ---- sockets
+
+inline void kWriteAll(int fd, const char* p, size_t n) {
+    while (n>0) {
+        ssize_t k = ::send(fd, p, n, kSendFlags);
+        if (k<=0) throw std::runtime_error("kdb+ IPC: connection lost while sending");
+        p+=k; n-=k;
+    }
+}
+
+inline bool kReadAll(int fd, char* p, size_t n) {
+    while (n>0) {
+        ssize_t k = ::recv(fd, p, n, 0);
+        if (k<=0) return false;
+        p+=k; n-=k;
+    }
+    return true;
+}
+
+// Next message from `fd`, decompressed, header included; empty when the peer closed.
+inline std::vector<char> kReadMessage(int fd) {
+    char h[8];
+    if (!kReadAll(fd, h, 8)) return {};
+    if (h[0]!=1) throw std::runtime_error("kdb+ IPC: big-endian peers are not supported");
+    uint32_t n; memcpy(&n, h+4, 4);
+    if (n<8) throw std::runtime_error("kdb+ IPC: bad message length");
+    std::vector<char> m(n);
+    memcpy(m.data(), h, 8);
+    if (!kReadAll(fd, m.data()+8, n-8)) throw std::runtime_error("kdb+ IPC: connection lost while receiving");
+    if (h[2]==1) return kDecompress(m.data(), m.size());
+    return m;
+}
+
+// Server side of the handshake; returns the agreed capability, or -1 if the client
+// went away before sending its credentials.
+inline int kAcceptHandshake(int fd, int capability=3) {
+    std::string creds;
+    char c;
+    while (true) {
+        if (!kReadAll(fd, &c, 1)) return -1;
+        if (c==0) break;
+        creds.push_back(c);
+    }
+    int offered = creds.empty() ? 0 : (uint8_t)creds.back();
+    char agreed = (char)std::min(offered<32 ? offered : 0, capability);
+    kWriteAll(fd, &agreed, 1);
+    return agreed;
+}
+
+class KConnection {
+    int fd{-1};
+    int cap{0};
+public:
+    KConnection(const std::string& host, int port, const std::string& auth) {
+        addrinfo hints{}, *res=nullptr;
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res)!=0 || !res)
+            throw std::runtime_error("cannot resolve "+host);
+        for (addrinfo* a=res; a; a=a->ai_next) {
+            fd = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+            if (fd<0) continue;
+            if (::connect(fd, a->ai_addr, a->ai_addrlen)==0) break;
+            ::close(fd); fd=-1;
+        }
+        freeaddrinfo(res);
+        if (fd<0) throw std::runtime_error("cannot connect to "+host+":"+std::to_string(port));
+        int one=1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+        std::string hello = auth; hello.push_back(3); hello.push_back(0);
+        kWriteAll(fd, hello.data(), hello.size());
+        char agreed;
+        if (!kReadAll(fd, &agreed, 1)) { ::close(fd); throw std::runtime_error("kdb+ handshake rejected (credentials?)"); }
+        cap = agreed;
+    }
+    ~KConnection(){ if (fd>=0) ::close(fd); }
+    KConnection(const KConnection&) = delete;
+    KConnection& operator=(const KConnection&) = delete;
+
+    int capability() const { return cap; }
+
+    // Sends `w` as a sync request and returns the raw response; a q error is thrown.
+    std::vector<char> call(KWriter& w, bool compress=false) {
+        auto m = w.message(KSYNC, compress && cap>=1);
+        kWriteAll(fd, m.data(), m.size());
+        auto r = kReadMessage(fd);
+        if (r.empty()) throw std::runtime_error("kdb+ IPC: connection closed");
+        if (r.size()>8 && (int8_t)r[8]==(int8_t)KERROR) {
+            KReader e(r.data()+8, r.size()-8);
+            throw std::runtime_error("q error: '"+std::string(e.read().syms[0]));
+        }
+        return r;
+    }
+
+    void async(KWriter& w, bool compress=false) {
+        auto m = w.message(KASYNC, compress && cap>=1);
+        kWriteAll(fd, m.data(), m.size());
+    }
+};
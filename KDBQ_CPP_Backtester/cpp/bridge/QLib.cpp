@@ -0,0 +1,148 @@
+// The fill model as a shared library for q, called in-process instead of through CSV
+// files and the backtester binary:
+//   bt:`:kdbq 2:(`backtest;3)
+//   fills:bt[quotes;orders;`latency_ticks`slip_bps!(2;0.5)]     / (::) for the defaults
+// quotes: ([] ts:timestamp; bid:float; ask:float; bsz:int; asz:int; ...) sorted by ts
+// orders: ([] ts:timestamp; side:`buy`sell; type:`market`limit; px; qty; tif:`IOC`GFD; [id])
+// returns ([] ts:timestamp; order_id:long; side; px:float; qty:int; liq)
+// Quote columns of those types are read where they are, inside the K objects; other
+// numeric types (real prices, long sizes, sizes with 0N) are converted first. Times
+// stay in q's epoch throughout: the model only compares them, so nothing is shifted.
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Engine.h"
+#include "BookView.h"
+#include "FillModel.h"
+#include "KApi.h"
+
+using namespace std;
+
+static K column(K t, const char* table, const char* name) {
+    K c = kColumn(t, name);
+    if (!c) throw runtime_error(string(table)+" has no "+name+" column");
+    return c;
+}
+
+static double atomValue(K a) {
+    switch (a->t) {
+        case -KF: return a->f;
+        case -KE: return a->e;
+        case -KJ: return (double)a->j;
+        case -KI: return a->i;
+        default: throw runtime_error("expected a number, got type "+to_string(a->t));
+    }
+}
+
+static double numAt(K c, int64_t i) {
+    switch (c->t) {
+        case KF: return kF(c)[i];
+        case KE: return kE(c)[i];
+        case KJ: return (double)kJ(c)[i];
+        case KI: return kI(c)[i];
+        default: throw runtime_error("expected a numeric column, got type "+to_string(c->t));
+    }
+}
+
+static QuoteColumns quoteColumns(K t) {
+    if (t->t!=KTABLE) throw runtime_error("quotes must be a table");
+    K ts = column(t, "quotes", "ts"), bid = column(t, "quotes", "bid"), ask = column(t, "quotes", "ask");
+    K bsz = column(t, "quotes", "bsz"), asz = column(t, "quotes", "asz");
+    if (ts->t!=KP) throw runtime_error("quotes ts must be timestamp");
+    const size_t n = ts->n;
+    auto conv = make_shared<QuoteBuilder>(); // holds whatever had to be converted
+    auto prices = [&](K c, Column<double>& own) -> ColumnView<double> {
+        if (c->t==KF) return {kF(c), n};
+        own.resize(n);
+        for (size_t i=0;i<n;i++) own[i] = numAt(c, i);
+        return {own.data(), n};
+    };
+    auto sizes = [&](K c, Column<int32_t>& own) -> ColumnView<int32_t> {
+        if (c->t==KI) {
+            const int32_t* p = kI(c);
+            bool nulls = false;
+            for (size_t i=0;i<n;i++) nulls |= p[i]==INT32_MIN;
+            if (!nulls) return {p, n};
+        }
+        own.resize(n);
+        for (size_t i=0;i<n;i++) { double x = numAt(c, i); own[i] = (x!=x || x<=INT32_MIN) ? 0 : (int32_t)x; } // 0N
+        return {own.data(), n};
+    };
+    ColumnView<double> b = prices(bid, conv->bid), a = prices(ask, conv->ask);
+    ColumnView<int32_t> bs = sizes(bsz, conv->bsz), as = sizes(asz, conv->asz);
+    const int64_t* tp = reinterpret_cast<const int64_t*>(kJ(ts));
+    if (!is_sorted(tp, tp+n)) throw runtime_error("quotes not sorted by ts");
+    return QuoteColumns(conv, {tp, n}, b, a, bs, as);
+}
+
+static vector<Order> ordersFromTable(K t) {
+    if (t->t!=KTABLE) throw runtime_error("orders must be a table");
+    K ts = column(t, "orders", "ts"), side = column(t, "orders", "side"), type = column(t, "orders", "type");
+    K px = column(t, "orders", "px"), qty = column(t, "orders", "qty"), tif = column(t, "orders", "tif");
+    K id = kColumn(t, "id");
+    if (ts->t!=KP) throw runtime_error("orders ts must be timestamp");
+    if (side->t!=KS || type->t!=KS || tif->t!=KS) throw runtime_error("orders side, type and tif must be symbols");
+    const int64_t n = ts->n;
+    vector<Order> v(n);
+    for (int64_t i=0;i<n;i++) {
+        Order& o = v[i];
+        o.ts = kJ(ts)[i];
+        o.side = kS(side)[i];
+        o.type = kS(type)[i];
+        o.px = numAt(px, i);
+        o.qty = (int)numAt(qty, i);
+        o.tif = kS(tif)[i];
+        o.id = id ? (int)numAt(id, i) : (int)i+1;
+    }
+    return v;
+}
+
+// (::), or a dict of `latency_ticks`slip_bps to numbers.
+static EngineParams engineParams(K p) {
+    EngineParams params;
+    if (p->t==KUNARY) return params;
+    if (p->t!=KDICT || kK(p)[0]->t!=KS) throw runtime_error("params must be a dict of symbols to numbers, or (::)");
+    K keys = kK(p)[0], vals = kK(p)[1];
+    for (int64_t i=0;i<keys->n;i++) {
+        double x = vals->t==0 ? atomValue(kK(vals)[i]) : numAt(vals, i);
+        string k = kS(keys)[i];
+        if (k=="latency_ticks") params.latency_ticks = (int)x;
+        else if (k=="slip_bps") params.slip_bps = x;
+        else throw runtime_error("unknown param "+k);
+    }
+    return params;
+}
+
+static K fillsTable(const vector<Fill>& fills) {
+    const int64_t n = fills.size();
+    K ts = ktn(KP, n), id = ktn(KJ, n), side = ktn(KS, n), px = ktn(KF, n), qty = ktn(KI, n), liq = ktn(KS, n);
+    for (int64_t i=0;i<n;i++) {
+        const Fill& f = fills[i];
+        kJ(ts)[i] = f.ts;
+        kJ(id)[i] = f.order_id;
+        kS(side)[i] = ss(const_cast<char*>(f.side.c_str()));
+        kF(px)[i] = f.px;
+        kI(qty)[i] = f.qty;
+        kS(liq)[i] = ss(const_cast<char*>(f.liq.c_str()));
+    }
+    K names = ktn(KS, 6);
+    const char* cols[6] = {"ts", "order_id", "side", "px", "qty", "liq"};
+    for (int c=0;c<6;c++) kS(names)[c] = ss(const_cast<char*>(cols[c]));
+    K vals = ktn(0, 6);
+    kK(vals)[0]=ts; kK(vals)[1]=id; kK(vals)[2]=side; kK(vals)[3]=px; kK(vals)[4]=qty; kK(vals)[5]=liq;
+    return xT(xD(names, vals));
+}
+
+extern "C" __attribute__((visibility("default"))) K backtest(K quotes, K orders, K params) {
+    try {
+        QuoteColumns q = quoteColumns(quotes);
+        vector<Order> o = ordersFromTable(orders);
+        FillModel model(q, engineParams(params));
+        return fillsTable(model.run(o));
+    } catch (const exception& e) {
+        return krr(ss(const_cast<char*>(e.what())));
+    }
+}
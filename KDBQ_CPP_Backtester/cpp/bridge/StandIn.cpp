@@ -0,0 +1,109 @@
+// Stand-in for a q server, for testing the bridge without kdb+: speaks the IPC
+// protocol and answers the two calls the client makes, as (`fn;args...) lists:
+//   .api.getWindow[sym;t0;t1]  quotes of `sym` with t0 <= ts <= t1 (from --quotes)
+//   .api.putFills[fills]       appends the fills table; returns the rows held so far
+// Connections are served one at a time; --once exits after the first disconnects.
+#include <iostream>
+#include <string>
+#include <vector>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "Loaders.h"
+#include "EngineTables.h"
+#include "KdbIpc.h"
+
+using namespace std;
+
+static int64_t fillsHeld = 0;
+
+static void answer(const KView& call, const QuoteColumns& quotes, const string& sym, KWriter& w) {
+    if (call.type!=0 || call.items.empty() || call.items[0].type!=-KS) {
+        w.error("stand-in evaluates only (`fn;args...) calls");
+        return;
+    }
+    string_view fn = call.items[0].syms[0];
+    if (fn==".api.getWindow" && call.items.size()==4) {
+        const KView &s = call.items[1], &a = call.items[2], &b = call.items[3];
+        if (s.type!=-KS || a.type!=-KP || b.type!=-KP) { w.error("type"); return; }
+        int64_t t0, t1;
+        memcpy(&t0, a.data, 8); memcpy(&t1, b.data, 8);
+        t0 += kQEpochNs; t1 += kQEpochNs;
+        size_t from=quotes.size(), to=quotes.size();
+        if (s.syms[0]==sym) {
+            from = lower_bound(quotes.ts.begin(), quotes.ts.end(), t0)-quotes.ts.begin();
+            to = upper_bound(quotes.ts.begin(), quotes.ts.end(), t1)-quotes.ts.begin();
+            if (to<from) to=from;
+        }
+        writeQuotesTable(w, quotes, from, to, sym);
+    } else if (fn==".api.putFills" && call.items.size()==2) {
+        const KView& t = call.items[1];
+        const KView* id = t.column("order_id");
+        if (!id) { w.error("type"); return; }
+        fillsHeld += id->n;
+        w.longAtom(fillsHeld);
+    } else {
+        w.error(string(fn));
+    }
+}
+
+int main(int argc, char** argv) {
+    string quotesPath, sym="DEMO";
+    int port=5001;
+    bool compress=false, once=false;
+    for (int i=1;i<argc;i++){
+        string a=argv[i];
+        auto get=[&](string k){ if(i+1>=argc) throw runtime_error("missing "+k); return string(argv[++i]); };
+        if (a=="--quotes") quotesPath=get("--quotes");
+        else if (a=="--port") port=stoi(get("--port"));
+        else if (a=="--sym") sym=get("--sym");
+        else if (a=="--compress") compress=true;
+        else if (a=="--once") once=true;
+        else cerr<<"unknown arg "<<a<<"\n";
+    }
+    if (quotesPath.empty()) {
+        cerr<<"Usage: kdbq_standin --quotes <quotes.csv> [--port 5001] [--sym DEMO] [--compress] [--once]\n";
+        return 2;
+    }
+    QuoteColumns quotes = loadQuotes(quotesPath, "on");
+
+    int ls = ::socket(AF_INET, SOCK_STREAM, 0);
+    int one=1;
+    setsockopt(ls, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (::bind(ls, (sockaddr*)&addr, sizeof addr)!=0 || ::listen(ls, 8)!=0) {
+        cerr<<"cannot listen on port "<<port<<"\n";
+        return 1;
+    }
+    cerr<<"stand-in q server on port "<<port<<" ("<<quotes.size()<<" "<<sym<<" quotes)\n";
+
+    do {
+        int fd = ::accept(ls, nullptr, nullptr);
+        if (fd<0) continue;
+        try {
+            if (kAcceptHandshake(fd)>=0) {
+                for (;;) {
+                    vector<char> m = kReadMessage(fd);
+                    if (m.empty()) break;
+                    KReader r(m.data()+8, m.size()-8);
+                    KView call = r.read();
+                    KWriter w;
+                    try { answer(call, quotes, sym, w); }
+                    catch (const exception& e) { w = KWriter(); w.error(e.what()); }
+                    if (m[1]==KSYNC) {
+                        auto out = w.message(KRESPONSE, compress);
+                        kWriteAll(fd, out.data(), out.size());
+                    }
+                }
+            }
+        } catch (const exception& e) {
+            cerr<<"connection dropped: "<<e.what()<<"\n";
+        }
+        ::close(fd);
+    } while (!once);
+    ::close(ls);
+    return 0;
+}
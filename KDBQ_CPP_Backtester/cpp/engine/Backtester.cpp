@@ -1,78 +1,36 @@
 #include <iostream>
 #include <fstream>
-#include <sstream>
+#include <chrono>
 #include <vector>
 #include <string>
-#include <unordered_map>
 #include <iomanip>
 #include <stdexcept>
 #include <cstdlib>
 #include "Engine.h"
+#include "Timestamp.h"
+#include "BookView.h"
+#include "FillModel.h"
+#include "Loaders.h"
+#include "SplayReader.h"
+#include "StreamEngine.h"
 
 using namespace std;
 
-static vector<string> splitCSV(const string& line) {
-    vector<string> out; string cur; bool inq=false;
-    for (char c: line) {
-        if (c=='"') inq=!inq;
-        else if (c==',' && !inq){ out.push_back(cur); cur.clear(); }
-        else cur.push_back(c);
-    }
-    out.push_back(cur);
-    return out;
-}
-
-static vector<BookTick> loadQuotes(const string& path) {
-    ifstream f(path);
-    if(!f) throw runtime_error("cannot open quotes: "+path);
-    string line; getline(f, line); // header
-    vector<BookTick> v; v.reserve(1<<20);
-    while (getline(f, line)) {
-        auto cols = splitCSV(line);
-        if (cols.size()<6) continue;
-        BookTick b;
-        b.ts = cols[0];
-        b.bid = stod(cols[2]);
-        b.ask = stod(cols[3]);
-        b.bsz = stoi(cols[4]);
-        b.asz = stoi(cols[5]);
-        v.push_back(b);
-    }
-    return v;
-}
-
-static vector<Order> loadOrders(const string& path) {
-    ifstream f(path);
-    if(!f) throw runtime_error("cannot open orders: "+path);
-    string line; getline(f, line); // header
-    vector<Order> v;
-    int id=1;
-    while (getline(f, line)) {
-        auto cols = splitCSV(line);
-        if (cols.size()<7) continue;
-        Order o;
-        o.ts = cols[0];
-        o.sym = cols[1];
-        o.side = cols[2];
-        o.type = cols[3];
-        o.px = stod(cols[4]);
-        o.qty = stoi(cols[5]);
-        o.tif = cols[6];
-        o.id = id++;
-        v.push_back(o);
-    }
-    return v;
-}
-
 static void ensureDir(const string& p) {
     string cmd = "mkdir -p \""+p+"\"";
     system(cmd.c_str());
 }
 
+static void writeFill(ostream& ff, const Fill& f) {
+    ff<<formatTimestamp(f.ts)<<","<<f.order_id<<","<<f.side<<","<<fixed<<setprecision(8)<<f.px<<","<<f.qty<<","<<f.liq<<"\n";
+}
+
 int main(int argc, char** argv) {
     ios::sync_with_stdio(false);
-    string quotesPath, ordersPath, outdir="artifact";
+    string quotesPath, ordersPath, outdir="artifact", simd="auto", cross="index", cache="on";
     EngineParams params;
+    SplayQuery splay;
+    bool stream=false;
     for (int i=1;i<argc;i++){
         string a=argv[i];
         auto get=[&](string k){ if(i+1>=argc) throw runtime_error("missing "+k); return string(argv[++i]); };
@@ -81,87 +39,75 @@ int main(int argc, char** argv) {
         else if (a=="--out") outdir=get("--out");
         else if (a=="--latency_ticks") params.latency_ticks=stoi(get("--latency_ticks"));
         else if (a=="--slip_bps") params.slip_bps=stod(get("--slip_bps"));
+        else if (a=="--simd") simd=get("--simd");
+        else if (a=="--cross") cross=get("--cross");
+        else if (a=="--cache") cache=get("--cache");
+        else if (a=="--stream") stream=true;
+        else if (a=="--hdb") splay.dir=get("--hdb");
+        else if (a=="--table") splay.table=get("--table");
+        else if (a=="--sym") splay.sym=get("--sym");
+        else if (a=="--dates") {
+            string d=get("--dates"); auto c=d.find(':');
+            splay.from=d.substr(0,c); splay.to=(c==string::npos ? d : d.substr(c+1));
+        }
         else cerr<<"unknown arg "<<a<<"\n";
     }
-    if (quotesPath.empty()||ordersPath.empty()) {
-        cerr<<"Usage: backtester --quotes <quotes.csv> --orders <orders.csv> --out <dir> --latency_ticks N --slip_bps B\n";
+    if (cross!="index" && cross!="scan") throw runtime_error("--cross must be index or scan");
+    if (cache!="on" && cache!="off" && cache!="rebuild" && cache!="verify")
+        throw runtime_error("--cache must be on, off, rebuild or verify");
+    if ((quotesPath.empty()&&splay.dir.empty())||ordersPath.empty()) {
+        cerr<<"Usage: backtester (--quotes <quotes.csv> | --hdb <dir> [--table quotes] [--sym S] [--dates D1[:D2]]) --orders <orders.csv> --out <dir> --latency_ticks N --slip_bps B [--stream] [--cache on|off|rebuild|verify] [--cross index|scan] [--simd auto|avx512|avx2|scalar]\n";
         return 2;
     }
+    if (stream && quotesPath.empty()) throw runtime_error("--stream reads quotes from a CSV (--quotes)");
     ensureDir(outdir);
+    string fillsPath = outdir + "/fills.csv";
 
-    auto quotes = loadQuotes(quotesPath);
-    auto orders = loadOrders(ordersPath);
-
-    // index quotes by "ts" string into position
-    unordered_map<string,int> qidx;
-    qidx.reserve(quotes.size()*2);
-    for (int i=0;i<(int)quotes.size();++i) qidx[quotes[i].ts]=i;
-
-    vector<Fill> fills;
-    fills.reserve(orders.size()*2);
+    if (stream) {
+        // one pass, fills written as they happen; memory does not grow with the quotes
+        auto t0 = chrono::steady_clock::now();
+        ofstream ff(fillsPath);
+        ff<<"ts,order_id,side,px,qty,liq\n";
+        StreamEngine eng(params);
+        size_t nFills=0;
+        size_t nOrders = streamBacktest(quotesPath, ordersPath, eng, [&](const Fill& f){ writeFill(ff, f); nFills++; });
+        ff.close();
+        cerr<<"Streamed "<<eng.quotesSeen()<<" quotes and "<<nOrders<<" orders in "<<fixed<<setprecision(3)
+            <<chrono::duration<double>(chrono::steady_clock::now()-t0).count()<<" s (peak "<<eng.peakOpenOrders()
+            <<" open orders)\n"<<defaultfloat;
+        cerr<<"Wrote "<<nFills<<" fills to "<<fillsPath<<"\n";
+        return 0;
+    }
 
-    auto slip = [&](double px, bool isBuy){
-        double s = params.slip_bps/10000.0 * px;
-        return isBuy ? px + s : px - s;
-    };
+    QuoteColumns quotes;
+    if (!splay.dir.empty()) {
+        auto t0 = chrono::steady_clock::now();
+        quotes = loadSplayedQuotes(splay);
+        reportLoad("quotes from kdb+", quotes.size(), quotes.size()*kQuoteRowBytes, t0);
+    } else {
+        quotes = loadQuotes(quotesPath, cache);
+    }
+    auto orders = loadOrders(ordersPath);
 
-    for (auto &o: orders){
-        auto it = qidx.find(o.ts);
-        if (it==qidx.end()) continue; // skip if timestamp not found
-        int arrival = it->second + params.latency_ticks;
-        if (arrival >= (int)quotes.size()) continue;
+    // the crossing index is built with the model unless --cross scan
+    auto t0 = chrono::steady_clock::now();
+    FillModel model(quotes, params, cross=="index");
+    if (model.usesIndex())
+        cerr<<"Built crossing index in "<<fixed<<setprecision(3)
+            <<chrono::duration<double>(chrono::steady_clock::now()-t0).count()<<" s\n"<<defaultfloat;
+    CrossScanner& scanner = model.crossScanner();
+    if (!scanner.use(simd)) cerr<<"--simd "<<simd<<" not available here; using "<<crossKernelName(scanner.kernel())<<"\n";
 
-        if (o.type=="market"){
-            auto &qt = quotes[arrival];
-            if (o.side=="buy"){
-                int qty = min(o.qty, qt.asz);
-                if (qty>0){
-                    Fill f{ o.id, qt.ts, slip(qt.ask,true), qty, o.side, "taker" };
-                    fills.push_back(f);
-                }
-            } else {
-                int qty = min(o.qty, qt.bsz);
-                if (qty>0){
-                    Fill f{ o.id, qt.ts, slip(qt.bid,false), qty, o.side, "taker" };
-                    fills.push_back(f);
-                }
-            }
-        } else if (o.type=="limit"){
-            // Scan forward until condition met or end (GFD) / immediate (IOC)
-            bool filled=false;
-            int start = arrival;
-            int end = (o.tif=="IOC" ? arrival : (int)quotes.size()-1);
-            for (int i=start;i<=end;i++){
-                auto &qt = quotes[i];
-                if (o.side=="buy"){
-                    if (qt.ask <= o.px){
-                        int qty = min(o.qty, qt.asz);
-                        if (qty>0){
-                            Fill f{ o.id, qt.ts, qt.ask, qty, o.side, "taker" };
-                            fills.push_back(f); filled=true; break;
-                        }
-                    }
-                } else {
-                    if (qt.bid >= o.px){
-                        int qty = min(o.qty, qt.bsz);
-                        if (qty>0){
-                            Fill f{ o.id, qt.ts, qt.bid, qty, o.side, "taker" };
-                            fills.push_back(f); filled=true; break;
-                        }
-                    }
-                }
-            }
-            (void)filled;
-        }
-    }
+    t0 = chrono::steady_clock::now();
+    vector<Fill> fills = model.run(orders);
+    double secs = chrono::duration<double>(chrono::steady_clock::now()-t0).count();
+    cerr<<"Simulated "<<orders.size()<<" orders in "<<fixed<<setprecision(3)<<secs<<" s ("
+        <<(model.usesIndex() ? "crossing index" : string(crossKernelName(scanner.kernel()))+" crossing scan")<<")\n"<<defaultfloat;
 
     // Write fills.csv and simple pnl.csv (mark to mid at same timestamp if available)
-    string fillsPath = outdir + "/fills.csv";
     ofstream ff(fillsPath);
     ff<<"ts,order_id,side,px,qty,liq\n";
-    for (auto &f: fills){
-        ff<<f.ts<<","<<f.order_id<<","<<f.side<<","<<fixed<<setprecision(8)<<f.px<<","<<f.qty<<","<<f.liq<<"\n";
-    }
+    for (auto &f: fills) writeFill(ff, f);
     ff.close();
 
     cerr<<"Wrote "<<fills.size()<<" fills to "<<fillsPath<<"\n";
@@ -1,2 +1,80 @@
 #pragma once
-// empty placeholder (kept for future expansion)
+// L1 quotes held column-wise (struct of arrays): each field is its own contiguous,
+// 64-byte aligned array, so a scan over one field (e.g. ask) streams only that field
+// through the cache and can be compared several prices per vector instruction.
+// QuoteBuilder owns columns while a loader fills them; QuoteColumns is the read-only
+// view the engine runs on, over either a builder's vectors or a mapped cache file.
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+#include "Engine.h"
+
+template<typename T, size_t Align=64>
+struct AlignedAllocator {
+    using value_type = T;
+    template<typename U> struct rebind { using other = AlignedAllocator<U, Align>; };
+    AlignedAllocator() = default;
+    template<typename U> AlignedAllocator(const AlignedAllocator<U, Align>&) {}
+    T* allocate(size_t n) { return static_cast<T*>(::operator new(n*sizeof(T), std::align_val_t(Align))); }
+    void deallocate(T* p, size_t) { ::operator delete(p, std::align_val_t(Align)); }
+    template<typename U> bool operator==(const AlignedAllocator<U, Align>&) const { return true; }
+    template<typename U> bool operator!=(const AlignedAllocator<U, Align>&) const { return false; }
+};
+
+template<typename T>
+using Column = std::vector<T, AlignedAllocator<T>>;
+
+template<typename T>
+class ColumnView {
+    const T* p{nullptr};
+    size_t n{0};
+public:
+    ColumnView() = default;
+    ColumnView(const T* data, size_t size) : p(data), n(size) {}
+    const T& operator[](size_t i) const { return p[i]; }
+    const T* data() const { return p; }
+    size_t size() const { return n; }
+    const T* begin() const { return p; }
+    const T* end() const { return p+n; }
+};
+
+struct QuoteBuilder {
+    Column<int64_t> ts;   // ns since epoch (UTC), ascending
+    Column<double> bid, ask;
+    Column<int32_t> bsz, asz;
+
+    size_t size() const { return ts.size(); }
+    void reserve(size_t n) { ts.reserve(n); bid.reserve(n); ask.reserve(n); bsz.reserve(n); asz.reserve(n); }
+    void push(const BookTick& b) {
+        ts.push_back(b.ts); bid.push_back(b.bid); ask.push_back(b.ask); bsz.push_back(b.bsz); asz.push_back(b.asz);
+    }
+};
+
+class QuoteColumns {
+    std::shared_ptr<const void> storage; // keeps the memory behind the views alive
+public:
+    ColumnView<int64_t> ts;
+    ColumnView<double> bid, ask;
+    ColumnView<int32_t> bsz, asz;
+
+    QuoteColumns() = default;
+
+    explicit QuoteColumns(QuoteBuilder&& b) {
+        auto owned = std::make_shared<QuoteBuilder>(std::move(b));
+        size_t n = owned->size();
+        ts = {owned->ts.data(), n};
+        bid = {owned->bid.data(), n}; ask = {owned->ask.data(), n};
+        bsz = {owned->bsz.data(), n}; asz = {owned->asz.data(), n};
+        storage = std::move(owned);
+    }
+
+    // Views into memory owned by `keep` (e.g. a mapped file).
+    QuoteColumns(std::shared_ptr<const void> keep, ColumnView<int64_t> t, ColumnView<double> b, ColumnView<double> a,
+                 ColumnView<int32_t> bs, ColumnView<int32_t> as)
+        : storage(std::move(keep)), ts(t), bid(b), ask(a), bsz(bs), asz(as) {}
+
+    size_t size() const { return ts.size(); }
+    BookTick at(size_t i) const { return BookTick{ts[i], bid[i], ask[i], bsz[i], asz[i]}; }
+};
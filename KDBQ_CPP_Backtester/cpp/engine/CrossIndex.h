@@ -0,0 +1,79 @@
+#pragma once
+// Index answering "first tick at or after `from` where a limit order at px is
+// marketable" in O(log n), built once per run in O(n). It is a tree of running minima
+// of the ask (and maxima of the bid) with fan-out 8: level 1 holds the min ask of each
+// block of 8 ticks, level 2 of each block of 64, and so on. Size-aware: a quote with
+// zero size on a side counts as no quote there (+inf ask / -inf bid), so the tick
+// found can always fill. A query scans the rest of its block, climbs while whole
+// blocks cannot cross, then descends into the first block that can: at most 8 entries
+// (one cache line) per level each way. Extra memory is about n/7 doubles per side.
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <vector>
+#include "BookView.h"
+
+class CrossIndex {
+    static constexpr size_t B = 8;
+    const QuoteColumns& q;
+    std::vector<Column<double>> minAsk, maxBid; // [k-1] is level k
+
+    double effAsk(size_t i) const { return q.asz[i]>0 && q.ask[i]==q.ask[i] ? q.ask[i] : std::numeric_limits<double>::infinity(); }
+    double effBid(size_t i) const { return q.bsz[i]>0 && q.bid[i]==q.bid[i] ? q.bid[i] : -std::numeric_limits<double>::infinity(); }
+
+    size_t levelSize(size_t k) const { return k==0 ? q.size() : minAsk[k-1].size(); }
+
+    template<bool Buy>
+    bool hit(size_t k, size_t i, double px) const {
+        if (Buy) return (k==0 ? effAsk(i) : minAsk[k-1][i]) <= px;
+        return (k==0 ? effBid(i) : maxBid[k-1][i]) >= px;
+    }
+
+    template<bool Buy>
+    size_t first(double px, size_t from) const {
+        const size_t n = q.size();
+        size_t i = from, k = 0;
+        for (;;) { // climb: rest of the current block, then the parent's next entry
+            size_t sz = levelSize(k);
+            if (i>=sz) return n;
+            size_t e = std::min((i/B+1)*B, sz);
+            while (i<e && !hit<Buy>(k, i, px)) ++i;
+            if (i<e) break;
+            if (e==sz) return n;
+            i = e/B; ++k;
+        }
+        while (k>0) { // descend: first child of the found entry that can cross
+            --k;
+            size_t e = std::min(i*B+B, levelSize(k));
+            i *= B;
+            while (i<e && !hit<Buy>(k, i, px)) ++i;
+        }
+        return i;
+    }
+
+public:
+    explicit CrossIndex(const QuoteColumns& quotes) : q(quotes) {
+        size_t sz = q.size();
+        for (size_t k=0; sz>1; k++) {
+            size_t up = (sz+B-1)/B;
+            Column<double> lo(up), hi(up);
+            for (size_t j=0;j<up;j++) {
+                double a = std::numeric_limits<double>::infinity(), b = -a;
+                for (size_t i=j*B, e=std::min(i+B, sz); i<e; i++) {
+                    a = std::min(a, k==0 ? effAsk(i) : minAsk[k-1][i]);
+                    b = std::max(b, k==0 ? effBid(i) : maxBid[k-1][i]);
+                }
+                lo[j]=a; hi[j]=b;
+            }
+            minAsk.push_back(std::move(lo));
+            maxBid.push_back(std::move(hi));
+            sz = up;
+        }
+    }
+
+    // First tick >= from where a buy (ask <= px, asz > 0) or sell (bid >= px, bsz > 0)
+    // limit at px is marketable; q.size() if none.
+    size_t firstCross(bool isBuy, double px, size_t from) const {
+        return isBuy ? first<true>(px, from) : first<false>(px, from);
+    }
+};
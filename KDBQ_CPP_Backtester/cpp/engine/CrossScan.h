@@ -0,0 +1,130 @@
+#pragma once
+// First-crossing search for limit orders: the first tick in [from, to) where a buy
+// limit meets the offer (ask <= px, asz > 0) or a sell limit meets the bid
+// (bid >= px, bsz > 0). The price test runs 8 doubles per instruction with AVX-512
+// or 4 with AVX2 (two vectors per step either way); candidate ticks are then checked
+// for size in scalar code, since a quote with zero size is rare. The kernel is picked
+// once at startup from what the CPU supports; other targets use the scalar loop.
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "BookView.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define KDBQ_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+enum class CrossKernel { SCALAR, AVX2, AVX512 };
+
+inline const char* crossKernelName(CrossKernel k) {
+    switch (k) {
+        case CrossKernel::SCALAR: return "scalar";
+        case CrossKernel::AVX2: return "avx2";
+        case CrossKernel::AVX512: return "avx512";
+    }
+    return "scalar";
+}
+
+// Buy: first i with px[i] <= limit; sell: first i with px[i] >= limit; in both cases
+// sz[i] > 0. Returns `to` when there is none.
+template<bool Buy>
+inline size_t firstCrossScalar(const double* px, const int32_t* sz, size_t from, size_t to, double limit) {
+    for (size_t i=from;i<to;i++)
+        if ((Buy ? px[i]<=limit : px[i]>=limit) && sz[i]>0) return i;
+    return to;
+}
+
+#ifdef KDBQ_X86_SIMD
+// Bits of `mask` are lanes i..i+k whose price crosses; returns the first with size.
+inline bool firstSized(uint32_t mask, const int32_t* sz, size_t i, size_t& hit) {
+    while (mask) {
+        size_t j = i+__builtin_ctz(mask);
+        if (sz[j]>0) { hit=j; return true; }
+        mask &= mask-1;
+    }
+    return false;
+}
+
+template<bool Buy>
+__attribute__((target("avx2")))
+size_t firstCrossAvx2(const double* px, const int32_t* sz, size_t from, size_t to, double limit) {
+    constexpr int pred = Buy ? _CMP_LE_OQ : _CMP_GE_OQ;
+    const __m256d lim = _mm256_set1_pd(limit);
+    size_t i=from, hit;
+    for (; i+8<=to; i+=8) {
+        uint32_t m0 = (uint32_t)_mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(px+i), lim, pred));
+        uint32_t m1 = (uint32_t)_mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(px+i+4), lim, pred));
+        if ((m0|m1) && firstSized(m0|(m1<<4), sz, i, hit)) return hit;
+    }
+    return firstCrossScalar<Buy>(px, sz, i, to, limit);
+}
+
+template<bool Buy>
+__attribute__((target("avx512f")))
+size_t firstCrossAvx512(const double* px, const int32_t* sz, size_t from, size_t to, double limit) {
+    constexpr int pred = Buy ? _CMP_LE_OQ : _CMP_GE_OQ;
+    const __m512d lim = _mm512_set1_pd(limit);
+    size_t i=from, hit;
+    for (; i+16<=to; i+=16) {
+        uint32_t m0 = _mm512_cmp_pd_mask(_mm512_loadu_pd(px+i), lim, pred);
+        uint32_t m1 = _mm512_cmp_pd_mask(_mm512_loadu_pd(px+i+8), lim, pred);
+        if ((m0|m1) && firstSized(m0|(m1<<8), sz, i, hit)) return hit;
+    }
+    if (i+8<=to) {
+        uint32_t m = _mm512_cmp_pd_mask(_mm512_loadu_pd(px+i), lim, pred);
+        if (m && firstSized(m, sz, i, hit)) return hit;
+        i += 8;
+    }
+    return firstCrossScalar<Buy>(px, sz, i, to, limit);
+}
+#endif
+
+class CrossScanner {
+    using Fn = size_t(*)(const double*, const int32_t*, size_t, size_t, double);
+    CrossKernel k{CrossKernel::SCALAR};
+    Fn buy{firstCrossScalar<true>};
+    Fn sell{firstCrossScalar<false>};
+public:
+    // Best kernel the CPU supports.
+    CrossScanner() {
+#ifdef KDBQ_X86_SIMD
+        if (__builtin_cpu_supports("avx512f")) use(CrossKernel::AVX512);
+        else if (__builtin_cpu_supports("avx2")) use(CrossKernel::AVX2);
+#endif
+    }
+
+    // Returns false (and keeps the current kernel) if the CPU cannot run `kernel`.
+    bool use(CrossKernel kernel) {
+        switch (kernel) {
+            case CrossKernel::SCALAR:
+                buy = firstCrossScalar<true>; sell = firstCrossScalar<false>; break;
+#ifdef KDBQ_X86_SIMD
+            case CrossKernel::AVX2:
+                if (!__builtin_cpu_supports("avx2")) return false;
+                buy = firstCrossAvx2<true>; sell = firstCrossAvx2<false>; break;
+            case CrossKernel::AVX512:
+                if (!__builtin_cpu_supports("avx512f")) return false;
+                buy = firstCrossAvx512<true>; sell = firstCrossAvx512<false>; break;
+#endif
+            default: return false;
+        }
+        k = kernel;
+        return true;
+    }
+
+    bool use(const std::string& name) {
+        if (name=="scalar") return use(CrossKernel::SCALAR);
+        if (name=="avx2") return use(CrossKernel::AVX2);
+        if (name=="avx512") return use(CrossKernel::AVX512);
+        return name=="auto";
+    }
+
+    CrossKernel kernel() const { return k; }
+
+    // First tick in [from, to) where a limit order at `px` is marketable, or `to`.
+    size_t firstCross(const QuoteColumns& q, bool isBuy, double px, size_t from, size_t to) const {
+        return isBuy ? buy(q.ask.data(), q.asz.data(), from, to, px)
+                     : sell(q.bid.data(), q.bsz.data(), from, to, px);
+    }
+};
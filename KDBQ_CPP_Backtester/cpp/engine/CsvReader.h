@@ -0,0 +1,191 @@
+#pragma once
+// Zero-copy CSV reading: the file is mmapped read-only, rows are tokenized in place
+// into string_views over the mapping, and numbers are parsed with std::from_chars.
+// Loading a file makes no per-row heap allocations beyond what the caller keeps.
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class MappedFile {
+    const char* p{nullptr};
+    size_t n{0};
+public:
+    // `advice` is passed to madvise: MADV_SEQUENTIAL for one front-to-back pass (read
+    // ahead, drop behind), MADV_WILLNEED for data that will be read at random.
+    explicit MappedFile(const std::string& path, int advice=MADV_SEQUENTIAL) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd<0) throw std::runtime_error("cannot open "+path);
+        struct stat st{};
+        if (fstat(fd, &st)!=0) { ::close(fd); throw std::runtime_error("cannot stat "+path); }
+        n = (size_t)st.st_size;
+        if (n>0) {
+            void* m = mmap(nullptr, n, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (m==MAP_FAILED) { ::close(fd); throw std::runtime_error("cannot mmap "+path); }
+            madvise(m, n, advice);
+            p = static_cast<const char*>(m);
+        }
+        ::close(fd); // the mapping keeps the file referenced
+    }
+    ~MappedFile(){ if (p) munmap(const_cast<char*>(p), n); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return p; }
+    size_t size() const { return n; }
+};
+
+// Walks the lines of a buffer. Fields are split on ',' and a field that starts with '"'
+// runs to the next '"' (so it may contain commas; escaped quotes are not supported).
+class CsvCursor {
+    const char* p;
+    const char* end;
+    size_t lineNo{0};
+public:
+    CsvCursor(const char* begin, size_t size) : p(begin), end(begin+size) {}
+
+    bool done() const { return p>=end; }
+    size_t line() const { return lineNo; } // 1-based number of the last line read
+
+    std::string_view nextLine() {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', end-p));
+        const char* e = nl ? nl : end;
+        std::string_view s(p, e-p);
+        if (!s.empty() && s.back()=='\r') s.remove_suffix(1);
+        p = nl ? nl+1 : end;
+        ++lineNo;
+        return s;
+    }
+
+    // Splits the next line into f[0..N). Returns the line's field count, which may
+    // exceed N (the extra fields are dropped).
+    template<size_t N>
+    size_t row(std::string_view (&f)[N]) {
+        std::string_view s = nextLine();
+        const char* q = s.data();
+        const char* e = q+s.size();
+        size_t k=0;
+        for (;;) {
+            std::string_view field;
+            if (q<e && *q=='"') {
+                const char* close = static_cast<const char*>(memchr(q+1, '"', e-q-1));
+                if (!close) close = e;
+                field = std::string_view(q+1, close-q-1);
+                q = close<e ? close+1 : e;
+                const char* c = static_cast<const char*>(memchr(q, ',', e-q));
+                q = c ? c : e;
+            } else {
+                const char* c = static_cast<const char*>(memchr(q, ',', e-q));
+                const char* fe = c ? c : e;
+                field = std::string_view(q, fe-q);
+                q = fe;
+            }
+            if (k<N) f[k] = field;
+            ++k;
+            if (q>=e) break;
+            ++q; // past ','
+        }
+        return k;
+    }
+
+    // Rows left, guessed from the mean length of the next (up to) 64 lines; used to
+    // reserve output once instead of growing it.
+    size_t estimateRows() const {
+        const char* q = p;
+        size_t lines=0;
+        while (q<end && lines<64) {
+            const char* nl = static_cast<const char*>(memchr(q, '\n', end-q));
+            q = nl ? nl+1 : end;
+            ++lines;
+        }
+        if (lines==0) return 0;
+        size_t sampled = q-p;
+        return (size_t)((double)(end-p)*lines/sampled*1.05)+1;
+    }
+};
+
+// Reads a file front to back through a fixed-size buffer, a line at a time, for input
+// that should not be held in memory in full (streaming mode). Lines returned by
+// nextLine()/row() stay valid until the next call.
+class CsvStream {
+    int fd{-1};
+    std::string path;
+    std::vector<char> buf;
+    size_t pos{0}, len{0};
+    size_t lineNo{0};
+    bool eof{false};
+
+    // Moves the unread tail to the front and reads more after it.
+    void refill() {
+        memmove(buf.data(), buf.data()+pos, len-pos);
+        len -= pos; pos = 0;
+        if (len==buf.size()) buf.resize(buf.size()*2); // one line longer than the buffer
+        ssize_t r = ::read(fd, buf.data()+len, buf.size()-len);
+        if (r<0) throw std::runtime_error("cannot read "+path);
+        if (r==0) eof = true;
+        len += (size_t)r;
+    }
+public:
+    explicit CsvStream(const std::string& file, size_t chunk=1<<20) : path(file), buf(chunk) {
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd<0) throw std::runtime_error("cannot open "+path);
+#ifdef POSIX_FADV_SEQUENTIAL
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    }
+    ~CsvStream(){ if (fd>=0) ::close(fd); }
+    CsvStream(const CsvStream&) = delete;
+    CsvStream& operator=(const CsvStream&) = delete;
+
+    bool done() {
+        while (pos==len && !eof) refill();
+        return pos==len;
+    }
+    size_t line() const { return lineNo; }
+
+    std::string_view nextLine() {
+        size_t from = pos;
+        const char* nl;
+        while (!(nl = static_cast<const char*>(memchr(buf.data()+from, '\n', len-from))) && !eof) {
+            from = len-pos;
+            refill();
+        }
+        const char* b = buf.data()+pos;
+        const char* e = nl ? nl : buf.data()+len;
+        pos = nl ? nl-buf.data()+1 : len;
+        ++lineNo;
+        std::string_view s(b, e-b);
+        if (!s.empty() && s.back()=='\r') s.remove_suffix(1);
+        return s;
+    }
+
+    template<size_t N>
+    size_t row(std::string_view (&f)[N]) {
+        std::string_view s = nextLine();
+        return CsvCursor(s.data(), s.size()).row(f);
+    }
+};
+
+inline std::string_view trimField(std::string_view s) {
+    while (!s.empty() && (s.front()==' '||s.front()=='\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back()==' '||s.back()=='\t')) s.remove_suffix(1);
+    if (!s.empty() && s.front()=='+') s.remove_prefix(1);
+    return s;
+}
+
+template<typename T>
+inline T parseNumber(std::string_view s, const std::string& path, size_t line) {
+    s = trimField(s);
+    T v{};
+    auto r = std::from_chars(s.data(), s.data()+s.size(), v);
+    if (r.ec!=std::errc() || r.ptr!=s.data()+s.size())
+        throw std::runtime_error("bad number '"+std::string(s)+"' at "+path+":"+std::to_string(line));
+    return v;
+}
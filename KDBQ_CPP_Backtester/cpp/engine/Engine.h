@@ -1,10 +1,11 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <optional>
 
 struct BookTick {
-    std::string ts;   // ISO string for demo
+    int64_t ts{0};    // ns since epoch (UTC)
     double bid{0.0};
     double ask{0.0};
     int bsz{0};
@@ -12,7 +13,7 @@ struct BookTick {
 };
 
 struct Order {
-    std::string ts;   // submission timestamp (string idx for demo)
+    int64_t ts{0};    // submission time, ns since epoch (UTC)
     std::string sym;
     std::string side; // "buy" or "sell"
     std::string type; // "market" or "limit"
@@ -24,7 +25,7 @@ struct Order {
 
 struct Fill {
     int order_id{0};
-    std::string ts; // fill timestamp
+    int64_t ts{0};  // fill timestamp, ns since epoch (UTC)
     double px{0.0};
     int qty{0};
     std::string side; // copy from order
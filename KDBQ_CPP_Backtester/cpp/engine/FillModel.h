@@ -0,0 +1,69 @@
+#pragma once
+// The fill model: for each order, the quote in force when it was sent (as-of, like
+// q's aj) plus latency_ticks gives its arrival tick. Market orders take the arrival
+// quote (with slippage); limit orders fill at the first marketable tick from arrival,
+// to end of day for GFD or at arrival only for IOC. GFD limits resolve through the
+// crossing index (built once, O(log n) per order) unless it is turned off, in which
+// case they use the forward crossing scan.
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Engine.h"
+#include "BookView.h"
+#include "CrossIndex.h"
+#include "CrossScan.h"
+#include "Timestamp.h"
+
+class FillModel {
+    const QuoteColumns& q;
+    EngineParams params;
+    CrossScanner scanner;
+    std::unique_ptr<CrossIndex> index;
+
+    double slip(double px, bool isBuy) const {
+        double s = params.slip_bps/10000.0 * px;
+        return isBuy ? px + s : px - s;
+    }
+
+public:
+    FillModel(const QuoteColumns& quotes, const EngineParams& p, bool useIndex=true) : q(quotes), params(p) {
+        if (useIndex) index = std::make_unique<CrossIndex>(quotes);
+    }
+
+    CrossScanner& crossScanner() { return scanner; }
+    bool usesIndex() const { return index!=nullptr; }
+
+    // Appends the order's fill, if any.
+    void fill(const Order& o, std::vector<Fill>& out) const {
+        const size_t n = q.size();
+        long sent = asofIndex(q.ts.data(), n, o.ts);
+        if (sent<0) return; // sent before the first quote
+        size_t arrival = sent + params.latency_ticks;
+        if (arrival >= n) return;
+        bool isBuy = o.side=="buy";
+
+        if (o.type=="market"){
+            int qty = std::min(o.qty, isBuy ? q.asz[arrival] : q.bsz[arrival]);
+            if (qty>0){
+                double px = isBuy ? q.ask[arrival] : q.bid[arrival];
+                out.push_back(Fill{ o.id, q.ts[arrival], slip(px,isBuy), qty, o.side, "taker" });
+            }
+        } else if (o.type=="limit" && o.qty>0){
+            size_t end = (o.tif=="IOC" ? arrival+1 : n);
+            size_t i = (index && o.tif!="IOC") ? index->firstCross(isBuy, o.px, arrival)
+                                               : scanner.firstCross(q, isBuy, o.px, arrival, end);
+            if (i<end){
+                int qty = std::min(o.qty, isBuy ? q.asz[i] : q.bsz[i]);
+                out.push_back(Fill{ o.id, q.ts[i], isBuy ? q.ask[i] : q.bid[i], qty, o.side, "taker" });
+            }
+        }
+    }
+
+    std::vector<Fill> run(const std::vector<Order>& orders) const {
+        std::vector<Fill> fills;
+        fills.reserve(orders.size()*2);
+        for (const auto& o : orders) fill(o, fills);
+        return fills;
+    }
+};
@@ -0,0 +1,24 @@
+#pragma once
+// q type numbers and element widths, shared by the on-disk (splayed) reader and the
+// IPC bridge. A negative type is the atom of the positive (vector) type.
+#include <cstddef>
+#include <cstdint>
+
+enum KType : int {
+    KB=1, KG=2, KX=4, KH=5, KI=6, KJ=7, KE=8, KF=9, KC=10, KS=11, KP=12, KM=13, KD=14, KZ=15,
+    KN=16, KU=17, KV=18, KT=19, KENUM=20, KTABLE=98, KDICT=99, KUNARY=101, KERROR=-128
+};
+
+constexpr int64_t kQEpochNs = 946684800LL*1000000000LL; // 2000.01.01 in Unix ns
+
+// Bytes per element of a fixed-width vector type (or its atom); 0 for anything else.
+inline size_t kTypeWidth(int t) {
+    switch (t<0 ? -t : t) {
+        case KB: case KX: case KC: return 1;
+        case KH: return 2;
+        case KI: case KE: case KM: case KD: case KU: case KV: case KT: return 4;
+        case KJ: case KF: case KP: case KZ: case KN: return 8;
+        case KG: return 16;
+        default: return 0;
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+// Quote and order loaders shared by the backtester and the q bridge: CSV (through
+// the quote cache) into columns / orders, with load throughput reported on stderr.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Engine.h"
+#include "BookView.h"
+#include "CsvReader.h"
+#include "QuoteCache.h"
+#include "Timestamp.h"
+
+// Bytes per quote in column form (ts, bid, ask, bsz, asz).
+constexpr size_t kQuoteRowBytes = sizeof(int64_t)+2*sizeof(double)+2*sizeof(int32_t);
+
+inline void reportLoad(const char* what, size_t rows, size_t bytes, std::chrono::steady_clock::time_point t0) {
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+    double mb = bytes/1e6;
+    std::cerr<<"Loaded "<<rows<<" "<<what<<" ("<<std::fixed<<std::setprecision(1)<<mb<<" MB) in "<<std::setprecision(3)
+             <<secs<<" s, "<<std::setprecision(1)<<(secs>0 ? mb/secs : 0.0)<<" MB/s\n"<<std::defaultfloat;
+}
+
+inline int64_t parseTs(std::string_view s, const std::string& path, size_t line) {
+    int64_t ns;
+    if (!parseTimestamp(trimField(s), ns))
+        throw std::runtime_error("bad timestamp '"+std::string(s)+"' at "+path+":"+std::to_string(line));
+    return ns;
+}
+
+// One row of a quotes CSV: ts,sym,bid,ask,bsz,asz.
+inline BookTick quoteRow(const std::string_view (&cols)[6], const std::string& path, size_t line) {
+    BookTick b;
+    b.ts = parseTs(cols[0], path, line);
+    b.bid = parseNumber<double>(cols[2], path, line);
+    b.ask = parseNumber<double>(cols[3], path, line);
+    b.bsz = parseNumber<int>(cols[4], path, line);
+    b.asz = parseNumber<int>(cols[5], path, line);
+    return b;
+}
+
+// One row of an orders CSV: ts,sym,side,type,px,qty,tif.
+inline Order orderRow(const std::string_view (&cols)[7], int id, const std::string& path, size_t line) {
+    Order o;
+    o.ts = parseTs(cols[0], path, line);
+    o.sym.assign(cols[1]);
+    o.side.assign(cols[2]);
+    o.type.assign(cols[3]);
+    o.px = parseNumber<double>(cols[4], path, line);
+    o.qty = parseNumber<int>(cols[5], path, line);
+    o.tif.assign(cols[6]);
+    o.id = id;
+    return o;
+}
+
+inline QuoteColumns parseQuotes(const std::string& path) {
+    auto t0 = std::chrono::steady_clock::now();
+    MappedFile f(path);
+    CsvCursor c(f.data(), f.size());
+    if (!c.done()) c.nextLine(); // header
+    QuoteBuilder v; v.reserve(c.estimateRows());
+    std::string_view cols[6];
+    while (!c.done()) {
+        if (c.row(cols)<6) continue;
+        v.push(quoteRow(cols, path, c.line()));
+    }
+    if (!std::is_sorted(v.ts.begin(), v.ts.end()))
+        throw std::runtime_error("quotes not sorted by ts: "+path);
+    reportLoad("quotes", v.size(), f.size(), t0);
+    return QuoteColumns(std::move(v));
+}
+
+// cache: "on" maps <path>.qcache when it is current and (re)writes it otherwise;
+// "verify" also checks the cached data's checksum; "rebuild" always parses and
+// rewrites; "off" parses and leaves the cache alone.
+inline QuoteColumns loadQuotes(const std::string& path, const std::string& cache) {
+    SourceStamp src;
+    if (cache=="off" || !statSource(path, src)) return parseQuotes(path);
+    std::string cachePath = path+".qcache", why="rebuild requested";
+    if (cache!="rebuild") {
+        auto t0 = std::chrono::steady_clock::now();
+        if (auto q = openQuoteCache(cachePath, src, cache=="verify", why)) {
+            reportLoad("quotes from cache", q->size(), q->size()*kQuoteRowBytes, t0);
+            return *q;
+        }
+    }
+    auto q = parseQuotes(path);
+    if (why!="missing") std::cerr<<"Quote cache "<<cachePath<<": "<<why<<"; rebuilt\n";
+    if (!writeQuoteCache(cachePath, q, src)) std::cerr<<"cannot write quote cache "<<cachePath<<"\n";
+    return q;
+}
+
+inline std::vector<Order> loadOrders(const std::string& path) {
+    auto t0 = std::chrono::steady_clock::now();
+    MappedFile f(path);
+    CsvCursor c(f.data(), f.size());
+    if (!c.done()) c.nextLine(); // header
+    std::vector<Order> v; v.reserve(c.estimateRows());
+    std::string_view cols[7];
+    int id=1;
+    while (!c.done()) {
+        if (c.row(cols)<7) continue;
+        v.push_back(orderRow(cols, id++, path, c.line()));
+    }
+    reportLoad("orders", v.size(), f.size(), t0);
+    return v;
+}
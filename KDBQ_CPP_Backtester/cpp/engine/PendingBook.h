@@ -0,0 +1,54 @@
+#pragma once
+// Resting limit orders of one side, kept as a heap on limit price with the most
+// aggressive limit on top (highest bid, lowest offer). A quote then fills exactly the
+// orders it makes marketable, popping them off the top, so a tick costs O(log n) per
+// fill plus one comparison, however many orders are resting. Orders live in slots
+// that are reused; the heap itself moves only (price, slot) pairs.
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "Engine.h"
+
+template<bool Buy>
+class PendingBook {
+    struct Entry { double px; uint64_t seq; uint32_t slot; };
+    // std heaps keep the greatest element on top: for bids the highest price, for
+    // offers the lowest; equal prices in arrival order.
+    struct Lower {
+        bool operator()(const Entry& a, const Entry& b) const {
+            if (a.px!=b.px) return Buy ? a.px<b.px : a.px>b.px;
+            return a.seq>b.seq;
+        }
+    };
+    std::vector<Entry> heap;
+    std::vector<Order> slots;
+    std::vector<uint32_t> freeSlots;
+    uint64_t seq{0};
+
+public:
+    size_t size() const { return heap.size(); }
+    bool empty() const { return heap.empty(); }
+
+    // A NaN limit never crosses, so it is not kept.
+    void add(Order&& o) {
+        if (o.px!=o.px) return;
+        uint32_t s;
+        if (freeSlots.empty()) { s = (uint32_t)slots.size(); slots.push_back(std::move(o)); }
+        else { s = freeSlots.back(); freeSlots.pop_back(); slots[s] = std::move(o); }
+        heap.push_back(Entry{ slots[s].px, seq++, s });
+        std::push_heap(heap.begin(), heap.end(), Lower{});
+    }
+
+    // Calls fill(order) for, and removes, every order marketable against `touch` (the
+    // ask for bids, the bid for offers), best limit first.
+    template<typename F>
+    void popMarketable(double touch, F&& fill) {
+        while (!heap.empty() && (Buy ? heap.front().px>=touch : heap.front().px<=touch)) {
+            std::pop_heap(heap.begin(), heap.end(), Lower{});
+            uint32_t s = heap.back().slot;
+            heap.pop_back();
+            fill(slots[s]);
+            freeSlots.push_back(s);
+        }
+    }
+};
@@ -0,0 +1,177 @@
+#pragma once
+// Binary columnar cache of a quotes CSV. The first run that parses "<quotes>.csv"
+// writes "<quotes>.csv.qcache" next to it; later runs mmap the cache and use its
+// columns in place, so loading is a header check and concurrent runs share one copy
+// in the page cache. Layout (native byte order):
+//   CacheHeader | ts | bid | ask | bsz | asz     (each column starts 64-byte aligned)
+// The header records a magic, a format version, the schema (name, q type char, width,
+// offset and length of every column), the source CSV's size and mtime, a checksum of
+// the column data and a checksum of the header itself. A cache whose source stamp no
+// longer matches the CSV is stale and gets rebuilt; the data checksum is verified
+// only on request (--cache verify), since doing so reads every page.
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "BookView.h"
+#include "CsvReader.h"
+
+constexpr char kCacheMagic[8] = {'K','D','B','Q','C','O','L','\0'};
+constexpr uint32_t kCacheVersion = 1;
+constexpr uint32_t kCacheColumns = 5;
+
+struct CacheColumn {
+    char name[8];
+    char type;      // q type char: 'p' timestamp, 'f' float, 'i' int
+    uint8_t width;  // bytes per element
+    uint8_t pad[6];
+    uint64_t offset; // from the start of the file
+    uint64_t bytes;
+};
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t columns;
+    uint64_t rows;
+    uint64_t sourceBytes;   // size of the CSV the cache was built from
+    int64_t sourceMtimeNs;  // and its modification time
+    CacheColumn col[kCacheColumns];
+    uint64_t dataChecksum;
+    uint64_t headerChecksum; // of every header byte before this field
+};
+static_assert(std::is_trivially_copyable_v<CacheHeader>);
+
+struct SourceStamp {
+    uint64_t bytes{0};
+    int64_t mtimeNs{0};
+};
+
+inline bool statSource(const std::string& path, SourceStamp& s) {
+    struct stat st{};
+    if (stat(path.c_str(), &st)!=0) return false;
+    s.bytes = (uint64_t)st.st_size;
+#ifdef __APPLE__
+    s.mtimeNs = (int64_t)st.st_mtimespec.tv_sec*1000000000LL+st.st_mtimespec.tv_nsec;
+#else
+    s.mtimeNs = (int64_t)st.st_mtim.tv_sec*1000000000LL+st.st_mtim.tv_nsec;
+#endif
+    return true;
+}
+
+// Word-at-a-time multiply/xorshift hash; fast enough to run over a day of quotes.
+inline uint64_t checksum64(const void* data, size_t bytes, uint64_t h=0x243F6A8885A308D3ULL) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    size_t i=0;
+    for (; i+8<=bytes; i+=8) {
+        uint64_t w; memcpy(&w, p+i, 8);
+        h = (h^w)*0x9E3779B97F4A7C15ULL;
+        h ^= h>>29;
+    }
+    for (; i<bytes; i++) { h = (h^p[i])*0x100000001B3ULL; }
+    return h^bytes;
+}
+
+struct CacheSchema { const char* name; char type; uint8_t width; };
+constexpr CacheSchema kQuoteSchema[kCacheColumns] = {
+    {"ts",'p',8}, {"bid",'f',8}, {"ask",'f',8}, {"bsz",'i',4}, {"asz",'i',4}};
+
+inline const void* columnData(const QuoteColumns& q, size_t c) {
+    switch (c) {
+        case 0: return q.ts.data();
+        case 1: return q.bid.data();
+        case 2: return q.ask.data();
+        case 3: return q.bsz.data();
+        default: return q.asz.data();
+    }
+}
+
+inline uint64_t align64(uint64_t x) { return (x+63)&~uint64_t(63); }
+
+// Written to a temporary file and renamed into place, so a concurrent reader sees
+// either the old cache or the complete new one.
+inline bool writeQuoteCache(const std::string& path, const QuoteColumns& q, const SourceStamp& src) {
+    CacheHeader h{};
+    memcpy(h.magic, kCacheMagic, 8);
+    h.version = kCacheVersion;
+    h.columns = kCacheColumns;
+    h.rows = q.size();
+    h.sourceBytes = src.bytes;
+    h.sourceMtimeNs = src.mtimeNs;
+    uint64_t off = align64(sizeof(CacheHeader)), sum = 0x243F6A8885A308D3ULL;
+    for (size_t c=0;c<kCacheColumns;c++) {
+        CacheColumn& col = h.col[c];
+        strncpy(col.name, kQuoteSchema[c].name, sizeof col.name);
+        col.type = kQuoteSchema[c].type;
+        col.width = kQuoteSchema[c].width;
+        col.offset = off;
+        col.bytes = h.rows*col.width;
+        sum = checksum64(columnData(q, c), col.bytes, sum);
+        off = align64(off+col.bytes);
+    }
+    h.dataChecksum = sum;
+    h.headerChecksum = checksum64(&h, offsetof(CacheHeader, headerChecksum));
+
+    std::string tmp = path+".tmp."+std::to_string(getpid());
+    {
+        std::ofstream f(tmp, std::ios::binary|std::ios::trunc);
+        if (!f) return false;
+        static const char zeros[64] = {};
+        f.write(reinterpret_cast<const char*>(&h), sizeof h);
+        uint64_t at = sizeof h;
+        for (size_t c=0;c<kCacheColumns;c++) {
+            f.write(zeros, h.col[c].offset-at);
+            f.write(static_cast<const char*>(columnData(q, c)), h.col[c].bytes);
+            at = h.col[c].offset+h.col[c].bytes;
+        }
+        if (!f) { f.close(); std::remove(tmp.c_str()); return false; }
+    }
+    if (std::rename(tmp.c_str(), path.c_str())!=0) { std::remove(tmp.c_str()); return false; }
+    return true;
+}
+
+// The cache's columns, mapped, or nullopt with `why` saying what was wrong with it
+// ("missing", "stale", "corrupt: ...").
+inline std::optional<QuoteColumns> openQuoteCache(const std::string& path, const SourceStamp& src, bool verifyData,
+                                                  std::string& why) {
+    if (access(path.c_str(), R_OK)!=0) { why="missing"; return std::nullopt; }
+    std::shared_ptr<MappedFile> m;
+    try { m = std::make_shared<MappedFile>(path, MADV_WILLNEED); }
+    catch (const std::exception& e) { why=e.what(); return std::nullopt; }
+    CacheHeader h;
+    if (m->size()<sizeof h) { why="corrupt: truncated header"; return std::nullopt; }
+    memcpy(&h, m->data(), sizeof h);
+    if (memcmp(h.magic, kCacheMagic, 8)!=0) { why="corrupt: bad magic"; return std::nullopt; }
+    if (h.version!=kCacheVersion) { why="stale: format version "+std::to_string(h.version); return std::nullopt; }
+    if (h.headerChecksum!=checksum64(&h, offsetof(CacheHeader, headerChecksum))) {
+        why="corrupt: header checksum"; return std::nullopt;
+    }
+    if (h.sourceBytes!=src.bytes || h.sourceMtimeNs!=src.mtimeNs) { why="stale"; return std::nullopt; }
+    if (h.columns!=kCacheColumns) { why="corrupt: schema"; return std::nullopt; }
+    uint64_t sum = 0x243F6A8885A308D3ULL;
+    for (size_t c=0;c<kCacheColumns;c++) {
+        const CacheColumn& col = h.col[c];
+        if (strncmp(col.name, kQuoteSchema[c].name, sizeof col.name)!=0 || col.type!=kQuoteSchema[c].type ||
+            col.width!=kQuoteSchema[c].width || col.bytes!=h.rows*col.width || col.offset%64!=0 ||
+            col.offset>m->size() || col.bytes>m->size()-col.offset) {
+            why="corrupt: schema"; return std::nullopt;
+        }
+        if (verifyData) sum = checksum64(m->data()+col.offset, col.bytes, sum);
+    }
+    if (verifyData && sum!=h.dataChecksum) { why="corrupt: data checksum"; return std::nullopt; }
+
+    const char* base = m->data();
+    size_t n = h.rows;
+    auto col = [&](size_t c){ return base+h.col[c].offset; };
+    return QuoteColumns(m,
+        {reinterpret_cast<const int64_t*>(col(0)), n},
+        {reinterpret_cast<const double*>(col(1)), n}, {reinterpret_cast<const double*>(col(2)), n},
+        {reinterpret_cast<const int32_t*>(col(3)), n}, {reinterpret_cast<const int32_t*>(col(4)), n});
+}
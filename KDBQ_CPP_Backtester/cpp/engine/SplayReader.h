@@ -0,0 +1,208 @@
+#pragma once
+// Reads quotes straight from a kdb+ database on disk: a splayed table (one file per
+// column plus .d), a date partition holding one, or an HDB root of YYYY.MM.DD
+// partitions. Column files are mmapped and read as typed vectors; nothing is
+// converted to text. File layouts (kdb+ 3.x and later, uncompressed):
+//   mappable vector  fe 20 <type> <attr> 00 00 00 00 <count:8> <data...>
+//                    (an enumeration may start fd 20; its elements follow the same way)
+//   symbol list      ff 01 0b <attr> <count:4> <name\0 name\0 ...>   (sym file, .d)
+// Column types accepted: ts as timestamp (p), or time (t) / timespan (n) added to the
+// partition date; bid/ask as float (f) or real (e); bsz/asz as int (i), long (j) or
+// short (h); sym as an enumeration over the sym file or a plain symbol list.
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "BookView.h"
+#include "CsvReader.h"
+#include "KTypes.h"
+#include "Timestamp.h"
+
+struct KVector {
+    std::shared_ptr<MappedFile> file;
+    int type{0};
+    uint64_t n{0};
+    const char* data{nullptr};
+    size_t width{0};        // bytes per element
+    std::vector<std::string> syms; // type KS only
+};
+
+// Body of a serialized symbol list: <type 0b> <attr> <count:4> <names>.
+inline std::vector<std::string> parseKSymbols(const char* p, size_t size, const std::string& path) {
+    if (size<6 || (unsigned char)p[0]!=KS) throw std::runtime_error("not a symbol list: "+path);
+    uint32_t n; memcpy(&n, p+2, 4);
+    std::vector<std::string> out; out.reserve(n);
+    const char* q = p+6;
+    const char* end = p+size;
+    for (uint32_t i=0;i<n;i++) {
+        const char* z = static_cast<const char*>(memchr(q, 0, end-q));
+        if (!z) throw std::runtime_error("truncated symbol list: "+path);
+        out.emplace_back(q, z-q);
+        q = z+1;
+    }
+    return out;
+}
+
+inline KVector mapKVector(const std::string& path) {
+    KVector v;
+    v.file = std::make_shared<MappedFile>(path);
+    const char* p = v.file->data();
+    size_t size = v.file->size();
+    if (size>=8 && memcmp(p, "kxzipped", 8)==0) throw std::runtime_error("compressed column files not supported: "+path);
+    if (size<8) throw std::runtime_error("not a kdb+ column file: "+path);
+    unsigned char m0 = p[0], m1 = p[1];
+    if (m0==0xff && m1==0x01) { // non-mappable object, serialized
+        v.type = (unsigned char)p[2];
+        if (v.type!=KS) throw std::runtime_error("unsupported column type "+std::to_string(v.type)+": "+path);
+        v.syms = parseKSymbols(p+2, size-2, path);
+        v.n = v.syms.size();
+        return v;
+    }
+    if ((m0!=0xfe && m0!=0xfd) || m1!=0x20 || size<16) throw std::runtime_error("not a kdb+ column file: "+path);
+    v.type = (unsigned char)p[2];
+    memcpy(&v.n, p+8, 8);
+    v.data = p+16;
+    size_t avail = size-16;
+    if (v.type>=KENUM && v.type<77) {
+        // Enumeration indexes: 8 bytes wide in current kdb+, 4 in older files.
+        v.width = (v.n==0 || avail>=8*v.n) ? 8 : 4;
+    } else {
+        v.width = kTypeWidth(v.type);
+        if (v.width==0) throw std::runtime_error("unsupported column type "+std::to_string(v.type)+": "+path);
+    }
+    if (v.n>avail/std::max<size_t>(v.width, 1)) throw std::runtime_error("truncated column file: "+path);
+    return v;
+}
+
+inline double kFloatAt(const KVector& v, size_t i) {
+    if (v.type==KF) { double d; memcpy(&d, v.data+8*i, 8); return d; }
+    if (v.type==KE) { float f; memcpy(&f, v.data+4*i, 4); return f; }
+    throw std::runtime_error("price column must be float or real");
+}
+
+// Sizes: q nulls (0N) become 0, i.e. nothing shown.
+inline int32_t kIntAt(const KVector& v, size_t i) {
+    if (v.type==KI) { int32_t x; memcpy(&x, v.data+4*i, 4); return x==std::numeric_limits<int32_t>::min() ? 0 : x; }
+    if (v.type==KJ) { int64_t x; memcpy(&x, v.data+8*i, 8); return x==std::numeric_limits<int64_t>::min() ? 0 : (int32_t)x; }
+    if (v.type==KH) { int16_t x; memcpy(&x, v.data+2*i, 2); return x==std::numeric_limits<int16_t>::min() ? 0 : x; }
+    throw std::runtime_error("size column must be int, long or short");
+}
+
+// Unix ns, or INT64_MIN for a null.
+inline int64_t kTimeAt(const KVector& v, size_t i, int64_t dayNs) {
+    const int64_t null = std::numeric_limits<int64_t>::min();
+    if (v.type==KP) { int64_t x; memcpy(&x, v.data+8*i, 8); return x==null ? null : x+kQEpochNs; }
+    if (dayNs==null) throw std::runtime_error("ts column of type time/timespan needs a date partition");
+    if (v.type==KN) { int64_t x; memcpy(&x, v.data+8*i, 8); return x==null ? null : dayNs+x; }
+    if (v.type==KT) {
+        int32_t x; memcpy(&x, v.data+4*i, 4);
+        return x==std::numeric_limits<int32_t>::min() ? null : dayNs+(int64_t)x*1000000;
+    }
+    throw std::runtime_error("ts column must be timestamp, timespan or time");
+}
+
+inline uint64_t kEnumAt(const KVector& v, size_t i) {
+    if (v.width==8) { uint64_t x; memcpy(&x, v.data+8*i, 8); return x; }
+    uint32_t x; memcpy(&x, v.data+4*i, 4); return x;
+}
+
+// Unix ns of midnight for a "YYYY.MM.DD" partition name, or INT64_MIN if it is not one.
+inline int64_t partitionDayNs(const std::string& name) {
+    int64_t ns;
+    if (name.size()!=10 || !parseTimestamp(name+"D00:00:00", ns)) return std::numeric_limits<int64_t>::min();
+    return ns;
+}
+
+struct SplayQuery {
+    std::string dir;           // splayed table, partition, or HDB root
+    std::string table{"quotes"};
+    std::string sym;           // keep only this symbol ("" = all rows)
+    std::string from, to;      // partition range, inclusive ("" = open)
+};
+
+// The sym file enumerating a table's symbol column: the nearest "sym" file in the
+// partition directory or the HDB root above it.
+inline std::vector<std::string> loadSymFile(const std::filesystem::path& tableDir) {
+    std::filesystem::path d = tableDir.parent_path();
+    for (int up=0; up<2 && !d.empty(); up++, d=d.parent_path()) {
+        std::filesystem::path f = d/"sym";
+        if (!std::filesystem::is_regular_file(f)) continue;
+        MappedFile m(f.string());
+        if (m.size()<2 || (unsigned char)m.data()[0]!=0xff || (unsigned char)m.data()[1]!=0x01)
+            throw std::runtime_error("not a kdb+ sym file: "+f.string());
+        return parseKSymbols(m.data()+2, m.size()-2, f.string());
+    }
+    throw std::runtime_error("no sym file found above "+tableDir.string());
+}
+
+// Appends one splayed table's rows (only `sym`'s if set; rows with a null ts dropped).
+inline void appendSplay(const std::filesystem::path& dir, int64_t dayNs, const std::string& sym, QuoteBuilder& out) {
+    auto col = [&](const char* name){ return mapKVector((dir/name).string()); };
+    KVector ts = col("ts"), bid = col("bid"), ask = col("ask"), bsz = col("bsz"), asz = col("asz");
+    const uint64_t n = ts.n;
+    if (bid.n!=n || ask.n!=n || bsz.n!=n || asz.n!=n) throw std::runtime_error("column lengths differ in "+dir.string());
+
+    std::vector<char> keep; // empty = every row
+    if (!sym.empty()) {
+        KVector s = col("sym");
+        if (s.n!=n) throw std::runtime_error("column lengths differ in "+dir.string());
+        keep.assign(n, 0);
+        if (s.type==KS) {
+            for (uint64_t i=0;i<n;i++) keep[i] = s.syms[i]==sym;
+        } else {
+            std::vector<std::string> domain = loadSymFile(dir);
+            auto it = std::find(domain.begin(), domain.end(), sym);
+            if (it!=domain.end()) {
+                uint64_t want = it-domain.begin();
+                for (uint64_t i=0;i<n;i++) keep[i] = kEnumAt(s, i)==want;
+            }
+        }
+    }
+    const int64_t null = std::numeric_limits<int64_t>::min();
+    for (uint64_t i=0;i<n;i++) {
+        if (!keep.empty() && !keep[i]) continue;
+        int64_t t = kTimeAt(ts, i, dayNs);
+        if (t==null) continue;
+        out.push(BookTick{t, kFloatAt(bid, i), kFloatAt(ask, i), kIntAt(bsz, i), kIntAt(asz, i)});
+    }
+}
+
+// `q.dir` may be the splayed table itself, a partition holding `q.table`, or an HDB
+// root whose YYYY.MM.DD partitions (within from..to) are read in date order.
+inline QuoteColumns loadSplayedQuotes(const SplayQuery& q) {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::path(q.dir).lexically_normal();
+    if (dir.filename().empty()) dir = dir.parent_path();
+    std::vector<std::pair<fs::path, int64_t>> parts; // table dir, partition midnight
+    if (fs::exists(dir/".d")) {
+        parts.push_back({dir, partitionDayNs(dir.parent_path().filename().string())});
+    } else if (fs::exists(dir/q.table/".d")) {
+        parts.push_back({dir/q.table, partitionDayNs(dir.filename().string())});
+    } else if (fs::is_directory(dir)) {
+        for (const auto& e : fs::directory_iterator(dir)) {
+            std::string name = e.path().filename().string();
+            if (partitionDayNs(name)==std::numeric_limits<int64_t>::min()) continue;
+            if ((!q.from.empty() && name<q.from) || (!q.to.empty() && name>q.to)) continue;
+            if (fs::exists(e.path()/q.table/".d")) parts.push_back({e.path()/q.table, partitionDayNs(name)});
+        }
+        std::sort(parts.begin(), parts.end());
+    }
+    if (parts.empty()) throw std::runtime_error("no splayed '"+q.table+"' table under "+dir.string());
+
+    QuoteBuilder b;
+    size_t rows=0;
+    for (const auto& p : parts) {
+        std::error_code ec;
+        auto bytes = fs::file_size(p.first/"ts", ec);
+        if (!ec) rows += bytes/8;
+    }
+    b.reserve(rows);
+    for (const auto& p : parts) appendSplay(p.first, p.second, q.sym, b);
+    if (!std::is_sorted(b.ts.begin(), b.ts.end())) throw std::runtime_error("quotes not sorted by ts under "+dir.string());
+    return QuoteColumns(std::move(b));
+}
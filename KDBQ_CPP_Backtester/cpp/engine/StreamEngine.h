@@ -0,0 +1,125 @@
+#pragma once
+// The fill model as a single pass over time-ordered quotes and orders (--stream).
+// Memory holds only the latest quote, orders still inside their latency window, and
+// GFD limits resting until they cross, in price-sorted books so each tick touches
+// only the orders it fills; fills are handed out as they happen. Gives the
+// same fills as FillModel (in fill-time rather than order order), but orders must
+// be sorted by ts.
+//
+// The caller merges the two streams: each order is passed after every quote with
+// ts <= order ts and before the first quote after it, so that the quote in force when
+// it was sent is the last one seen.
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Engine.h"
+#include "CsvReader.h"
+#include "Loaders.h"
+#include "PendingBook.h"
+
+class StreamEngine {
+    struct InFlight { Order o; uint64_t arrival; };
+    EngineParams params;
+    BookTick last;
+    uint64_t ticks{0};
+    std::deque<InFlight> inFlight;  // sent, not arrived yet; arrival ascending
+    PendingBook<true> bids;         // GFD limits that arrived without crossing
+    PendingBook<false> offers;
+    std::vector<Fill> out;
+    size_t peakOpen{0};
+
+    double slip(double px, bool isBuy) const {
+        double s = params.slip_bps/10000.0 * px;
+        return isBuy ? px + s : px - s;
+    }
+    static bool crosses(const Order& o, const BookTick& b) {
+        return o.side=="buy" ? (b.ask<=o.px && b.asz>0) : (b.bid>=o.px && b.bsz>0);
+    }
+    // A limit that crosses `b` fills there, at the touch.
+    void fillLimit(const Order& o, const BookTick& b) {
+        bool isBuy = o.side=="buy";
+        out.push_back(Fill{ o.id, b.ts, isBuy ? b.ask : b.bid, std::min(o.qty, isBuy ? b.asz : b.bsz), o.side, "taker" });
+    }
+    // The order reaches the market at quote `b`.
+    void arrive(const Order& o, const BookTick& b) {
+        bool isBuy = o.side=="buy";
+        if (o.type=="market") {
+            int qty = std::min(o.qty, isBuy ? b.asz : b.bsz);
+            if (qty>0) out.push_back(Fill{ o.id, b.ts, slip(isBuy ? b.ask : b.bid, isBuy), qty, o.side, "taker" });
+        } else if (o.type=="limit" && o.qty>0) {
+            if (crosses(o, b)) fillLimit(o, b);
+            else if (o.tif!="IOC") { if (isBuy) bids.add(Order(o)); else offers.add(Order(o)); }
+        }
+    }
+
+public:
+    explicit StreamEngine(const EngineParams& p) : params(p) {}
+
+    void quote(const BookTick& b) {
+        if (ticks>0 && b.ts<last.ts) throw std::runtime_error("quotes not sorted by ts");
+        uint64_t i = ticks++;
+        if (b.asz>0) bids.popMarketable(b.ask, [&](const Order& o){ fillLimit(o, b); });
+        if (b.bsz>0) offers.popMarketable(b.bid, [&](const Order& o){ fillLimit(o, b); });
+        while (!inFlight.empty() && inFlight.front().arrival==i) {
+            arrive(inFlight.front().o, b);
+            inFlight.pop_front();
+        }
+        last = b;
+    }
+
+    void order(Order&& o) {
+        if (ticks==0) return; // sent before the first quote
+        uint64_t arrival = ticks-1+params.latency_ticks;
+        if (arrival==ticks-1) arrive(o, last);
+        else inFlight.push_back(InFlight{ std::move(o), arrival });
+        peakOpen = std::max(peakOpen, openOrders());
+    }
+
+    // Fills since the last call; the caller writes them out and clears the vector.
+    std::vector<Fill>& fills() { return out; }
+    uint64_t quotesSeen() const { return ticks; }
+    size_t openOrders() const { return inFlight.size()+bids.size()+offers.size(); }
+    size_t peakOpenOrders() const { return peakOpen; }
+};
+
+// Streams the quotes and orders CSVs through a StreamEngine, passing every fill to
+// `sink` as soon as it is made. Returns the number of orders read.
+template<typename Sink>
+inline size_t streamBacktest(const std::string& quotesPath, const std::string& ordersPath, StreamEngine& eng, Sink&& sink) {
+    CsvStream qs(quotesPath), os(ordersPath);
+    if (!qs.done()) qs.nextLine(); // headers
+    if (!os.done()) os.nextLine();
+    std::string_view qc[6], oc[7];
+    auto nextOrder = [&](Order& o, int id) {
+        while (!os.done()) {
+            if (os.row(oc)<7) continue;
+            o = orderRow(oc, id, ordersPath, os.line());
+            return true;
+        }
+        return false;
+    };
+    Order o;
+    int id = 1;
+    bool haveOrder = nextOrder(o, id);
+    int64_t lastOrderTs = INT64_MIN;
+    auto drain = [&]{ for (const Fill& f : eng.fills()) sink(f); eng.fills().clear(); };
+    auto pass = [&]{
+        if (o.ts<lastOrderTs) throw std::runtime_error("orders not sorted by ts (needed for --stream): "+ordersPath);
+        lastOrderTs = o.ts;
+        eng.order(std::move(o));
+        haveOrder = nextOrder(o, ++id);
+    };
+    while (!qs.done()) {
+        if (qs.row(qc)<6) continue;
+        BookTick b = quoteRow(qc, quotesPath, qs.line());
+        while (haveOrder && o.ts<b.ts) pass(); // their as-of quote is the previous one
+        eng.quote(b);
+        drain();
+    }
+    while (haveOrder) pass();
+    drain();
+    return id-1;
+}
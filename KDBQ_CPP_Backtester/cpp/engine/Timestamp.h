@@ -0,0 +1,91 @@
+#pragma once
+// Timestamps as int64 nanoseconds since the Unix epoch (UTC), parsed once at load.
+// Accepts ISO ("2025-09-03T09:30:00.010000", ' ' also allowed as separator, optional
+// trailing 'Z') and q ("2025.09.03D09:30:00.010000000"); up to 9 fractional digits.
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+// Days from 1970-01-01 to y-m-d (proleptic Gregorian; H. Hinnant's algorithm).
+constexpr int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+    y -= m<=2;
+    const int64_t era = (y>=0 ? y : y-399)/400;
+    const unsigned yoe = (unsigned)(y-era*400);
+    const unsigned doy = (153*(m>2 ? m-3 : m+9)+2)/5+d-1;
+    const unsigned doe = yoe*365+yoe/4-yoe/100+doy;
+    return era*146097+(int64_t)doe-719468;
+}
+
+constexpr void civilFromDays(int64_t z, int64_t& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    const int64_t era = (z>=0 ? z : z-146096)/146097;
+    const unsigned doe = (unsigned)(z-era*146097);
+    const unsigned yoe = (doe-doe/1460+doe/36524-doe/146096)/365;
+    const unsigned doy = doe-(365*yoe+yoe/4-yoe/100);
+    const unsigned mp = (5*doy+2)/153;
+    d = doy-(153*mp+2)/5+1;
+    m = mp<10 ? mp+3 : mp-9;
+    y = (int64_t)yoe+era*400+(m<=2);
+}
+
+inline bool parseTimestamp(std::string_view s, int64_t& ns) {
+    if (s.size()<19) return false;
+    auto num=[&](size_t i, int n, int& v){
+        v=0;
+        for (int k=0;k<n;k++){ char c=s[i+k]; if (c<'0'||c>'9') return false; v=v*10+(c-'0'); }
+        return true;
+    };
+    int Y,M,D,h,mi,sec;
+    if (!num(0,4,Y)||!num(5,2,M)||!num(8,2,D)||!num(11,2,h)||!num(14,2,mi)||!num(17,2,sec)) return false;
+    if (!((s[4]=='-'&&s[7]=='-')||(s[4]=='.'&&s[7]=='.'))) return false;
+    if (s[10]!='T'&&s[10]!=' '&&s[10]!='D') return false;
+    if (s[13]!=':'||s[16]!=':') return false;
+    if (M<1||M>12||D<1||D>31||h>23||mi>59||sec>59) return false;
+    int64_t frac=0;
+    size_t i=19;
+    if (i<s.size() && s[i]=='.') {
+        int digits=0;
+        for (++i; i<s.size() && s[i]>='0' && s[i]<='9'; ++i)
+            if (digits<9){ frac=frac*10+(s[i]-'0'); ++digits; }
+        if (digits==0) return false;
+        for (; digits<9; ++digits) frac*=10;
+    }
+    if (i<s.size() && s[i]=='Z') ++i;
+    if (i!=s.size()) return false;
+    ns = (daysFromCivil(Y,M,D)*86400+h*3600+mi*60+sec)*1000000000LL+frac;
+    return true;
+}
+
+// ISO form; the fraction is printed only when non-zero, as 6 digits when it is whole
+// microseconds and 9 otherwise (the shape the sample data and Python's isoformat use).
+inline std::string formatTimestamp(int64_t ns) {
+    int64_t secs = ns>=0 ? ns/1000000000LL : -((-ns+999999999LL)/1000000000LL);
+    int64_t frac = ns-secs*1000000000LL;
+    int64_t days = secs>=0 ? secs/86400 : -((-secs+86399)/86400);
+    int64_t sod = secs-days*86400;
+    int64_t y; unsigned m, d;
+    civilFromDays(days, y, m, d);
+    char buf[48];
+    int n = snprintf(buf, sizeof buf, "%04lld-%02u-%02uT%02d:%02d:%02d", (long long)y, m, d,
+                     (int)(sod/3600), (int)(sod/60%60), (int)(sod%60));
+    if (frac%1000==0 && frac!=0) n += snprintf(buf+n, sizeof buf-n, ".%06lld", (long long)(frac/1000));
+    else if (frac!=0) n += snprintf(buf+n, sizeof buf-n, ".%09lld", (long long)frac);
+    return std::string(buf, n);
+}
+
+// As-of lookup, like q's aj: index of the last t[i] <= x in ascending t[0..n), or -1
+// when x precedes every element. Equal times resolve to the last of the run. The loop
+// is branch-free (the compare becomes a conditional move), so it costs log2(n) loads
+// with no mispredictions.
+inline long asofIndex(const int64_t* t, size_t n, int64_t x) {
+    if (n==0 || x<t[0]) return -1;
+    const int64_t* base = t;
+    while (n>1) {
+        size_t half = n/2;
+        base = base[half]<=x ? base+half : base;
+        n -= half;
+    }
+    return (long)(base-t);
+}